@@ -100,13 +100,22 @@ esptool.py --chip esp32c3 merge_bin -o releases/irk-finder-esp32c3.bin \
     0x10000 .pio/build/esp32c3/firmware.bin \
     2>/dev/null
 
+# OTA images for /api/ota: the app image alone, gzipped, plus the SHA-256
+# of the uncompressed image. esp32dev uses huge_app.csv (single app slot)
+# and has no OTA image.
+echo -e "${YELLOW}Creating OTA images...${NC}"
+for CHIP in esp32s3 esp32c3; do
+    gzip -9 -n -c .pio/build/$CHIP/firmware.bin > releases/irk-finder-$CHIP-ota.bin.gz
+    sha256sum .pio/build/$CHIP/firmware.bin | cut -d' ' -f1 > releases/irk-finder-$CHIP-ota.bin.sha256
+done
+
 echo ""
 echo -e "${GREEN}════════════════════════════════════════════${NC}"
 echo -e "${GREEN}✓ Release build complete!${NC}"
 echo -e "${GREEN}════════════════════════════════════════════${NC}"
 echo ""
 echo "Release binaries created in releases/:"
-ls -lh releases/*.bin
+ls -lh releases/*.bin releases/*.bin.gz
 echo ""
 echo -e "${YELLOW}Note: These builds use DEFAULT credentials from config.h${NC}"
 echo "Users will need to configure WiFi via the AP portal."
@@ -0,0 +1,93 @@
+#ifndef APP_CONFIG_H
+#define APP_CONFIG_H
+
+/*
+ * The build configuration as one compile-time object.
+ *
+ * config.h holds the overridable macros that .env and build flags set. This
+ * gathers them into APP_CONFIG, checks that they fit together, and is what
+ * the firmware reads instead of repeating literals. Everything is constant,
+ * so branches on APP_CONFIG fold away; code that needs a library of a
+ * disabled feature is kept out with #if on the same macros.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+// Macro value as a string literal, for text assembled at compile time
+#define CONFIG_STR_(x) #x
+#define CONFIG_STR(x) CONFIG_STR_(x)
+
+struct BleConfig {
+    const char* name;
+    uint32_t passkey;
+    uint16_t advIntervalMin;        // 0.625 ms units
+    uint16_t advIntervalMax;
+    uint16_t advConnMinInterval;    // 1.25 ms units, announced in the advertising data
+    uint16_t advConnMaxInterval;
+};
+
+struct NetConfig {
+    const char* hostname;
+    uint16_t webPort;
+    const char* apSsid;
+    const char* apPassword;
+};
+
+struct FeatureConfig {
+    bool web;                       // WiFi and the web server (not headless)
+    bool apMode;
+    bool forceApMode;               // skip the station and start the AP
+    bool captiveDns;
+    bool mdns;
+    bool webUi;
+};
+
+struct AppConfig {
+    BleConfig ble;
+    NetConfig net;
+    FeatureConfig features;
+};
+
+constexpr AppConfig APP_CONFIG = {
+    {BLE_DEVICE_NAME, BLE_PASSKEY, BLE_ADV_INTERVAL_MIN, BLE_ADV_INTERVAL_MAX,
+     BLE_ADV_CONN_MIN_INTERVAL, BLE_ADV_CONN_MAX_INTERVAL},
+    {MDNS_HOSTNAME, WEB_SERVER_PORT, AP_SSID, AP_PASSWORD},
+    {!HEADLESS_MODE,
+     !HEADLESS_MODE && AP_MODE_ENABLED,
+     !HEADLESS_MODE && AP_MODE_ENABLED && USE_AP_MODE,
+     !HEADLESS_MODE && AP_MODE_ENABLED && CAPTIVE_DNS_ENABLED,
+     !HEADLESS_MODE && MDNS_ENABLED,
+     !HEADLESS_MODE && WEB_UI_ENABLED},
+};
+
+namespace appconfig {
+
+constexpr size_t length(const char* s) {
+    return *s ? 1 + length(s + 1) : 0;
+}
+
+}  // namespace appconfig
+
+// The setup page prints the passkey from CONFIG_STR(BLE_PASSKEY), which
+// cannot zero-pad
+static_assert(APP_CONFIG.ble.passkey >= 100000 && APP_CONFIG.ble.passkey <= 999999,
+              "BLE_PASSKEY must be six digits without a leading zero");
+// The name goes into the 31-byte scan response
+static_assert(appconfig::length(APP_CONFIG.ble.name) > 0 && appconfig::length(APP_CONFIG.ble.name) <= 29,
+              "BLE_DEVICE_NAME must be 1-29 characters");
+static_assert(APP_CONFIG.ble.advIntervalMin >= 0x20 && APP_CONFIG.ble.advIntervalMax <= 0x4000 &&
+              APP_CONFIG.ble.advIntervalMin <= APP_CONFIG.ble.advIntervalMax,
+              "Advertising interval must be 0x20-0x4000 with min <= max");
+static_assert(APP_CONFIG.ble.advConnMinInterval >= 0x6 && APP_CONFIG.ble.advConnMaxInterval <= 0xC80 &&
+              APP_CONFIG.ble.advConnMinInterval <= APP_CONFIG.ble.advConnMaxInterval,
+              "Preferred connection interval must be 0x6-0xC80 with min <= max");
+static_assert(appconfig::length(APP_CONFIG.net.hostname) > 0 && appconfig::length(APP_CONFIG.net.hostname) <= 63,
+              "MDNS_HOSTNAME must be 1-63 characters");
+static_assert(!APP_CONFIG.features.apMode || appconfig::length(APP_CONFIG.net.apPassword) == 0 ||
+              (appconfig::length(APP_CONFIG.net.apPassword) >= 8 && appconfig::length(APP_CONFIG.net.apPassword) <= 63),
+              "AP_PASSWORD must be empty (open AP) or 8-63 characters");
+static_assert(!USE_AP_MODE || AP_MODE_ENABLED, "USE_AP_MODE needs AP_MODE_ENABLED");
+
+#endif
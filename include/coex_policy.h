@@ -0,0 +1,26 @@
+#ifndef COEX_POLICY_H
+#define COEX_POLICY_H
+
+#include <stdint.h>
+
+// WiFi/BLE radio coexistence preference, switched with the pairing state:
+// the pairing policy applies from BLE connect until authentication completes
+// or the link drops, the idle policy the rest of the time.
+// Values match esp_coex_prefer_t.
+
+#define COEX_PREFER_WIFI    0
+#define COEX_PREFER_BT      1
+#define COEX_PREFER_BALANCE 2
+
+void coex_policy_begin();
+void coex_policy_pairing_started();
+void coex_policy_pairing_finished();
+
+bool coex_policy_set(uint8_t pairingPolicy, uint8_t idlePolicy);
+uint8_t coex_policy_pairing();
+uint8_t coex_policy_idle();
+
+const char* coex_policy_name(uint8_t policy);
+int coex_policy_parse(const char* name);    // -1 if unknown
+
+#endif
@@ -1,6 +1,12 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+// Headless build: compile out WiFi, the web server, captive DNS and mDNS.
+// IRKs are then only reported over the serial port.
+#ifndef HEADLESS_MODE
+#define HEADLESS_MODE 0
+#endif
+
 // WiFi Configuration
 // These can be overridden by values from .env file
 #ifndef WIFI_SSID
@@ -24,20 +30,427 @@
 #define AP_PASSWORD "12345678"
 #endif
 
+// Fallback access point with the WiFi setup page when the station cannot
+// connect. 0 compiles out AP mode, so the credentials must come from .env.
+#ifndef AP_MODE_ENABLED
+#define AP_MODE_ENABLED 1
+#endif
+
+// Captive portal DNS while in AP mode (requires AP_MODE_ENABLED)
+#ifndef CAPTIVE_DNS_ENABLED
+#define CAPTIVE_DNS_ENABLED 1
+#endif
+
+// mDNS responder announcing <MDNS_HOSTNAME>.local. The hostname also names
+// the device in shipped logs.
+#ifndef MDNS_ENABLED
+#define MDNS_ENABLED 1
+#endif
+
+#ifndef MDNS_HOSTNAME
+#define MDNS_HOSTNAME "esp32-irk-finder"
+#endif
+
 // BLE Configuration
 #ifndef BLE_DEVICE_NAME
 #define BLE_DEVICE_NAME "ESP32_IRK_FINDER"
 #endif
 
+// Static passkey, six digits without a leading zero
 #ifndef BLE_PASSKEY
 #define BLE_PASSKEY 123456
 #endif
 
+// Advertising interval (0.625 ms units)
+#ifndef BLE_ADV_INTERVAL_MIN
+#define BLE_ADV_INTERVAL_MIN 0x100
+#endif
+
+#ifndef BLE_ADV_INTERVAL_MAX
+#define BLE_ADV_INTERVAL_MAX 0x100
+#endif
+
+// Preferred connection interval announced in the advertising data
+// (1.25 ms units)
+#ifndef BLE_ADV_CONN_MIN_INTERVAL
+#define BLE_ADV_CONN_MIN_INTERVAL 0x0006
+#endif
+
+#ifndef BLE_ADV_CONN_MAX_INTERVAL
+#define BLE_ADV_CONN_MAX_INTERVAL 0x0010
+#endif
+
+// BLE-only controller: release Classic BT memory and start the controller in
+// BLE mode only. Enabled by the esp32dev_ble, esp32s3 and esp32c3 envs.
+#ifndef BT_BLE_ONLY
+#define BT_BLE_ONLY 0
+#endif
+
+// 1: minimal attribute table (one encrypted-read characteristic under the
+// advertised service UUID, which is still Heart Rate). 0: full Heart Rate
+// service table. Off until its effect on pairing time has been measured.
+#ifndef GATT_DB_MINIMAL
+#define GATT_DB_MINIMAL 0
+#endif
+
+// Maximum simultaneous BLE links the controller reserves memory for.
+// One phone pairs at a time, so a single link is enough.
+#ifndef BT_BLE_MAX_CONN
+#define BT_BLE_MAX_CONN 1
+#endif
+
 // Web Server Configuration
 #ifndef WEB_SERVER_PORT
 #define WEB_SERVER_PORT 80
 #endif
 
+// Status and WiFi setup pages. 0 leaves only the JSON API.
+#ifndef WEB_UI_ENABLED
+#define WEB_UI_ENABLED 1
+#endif
+
+// MQTT publisher (requires WiFi station mode)
+#ifndef MQTT_ENABLED
+#define MQTT_ENABLED 0
+#endif
+
+#ifndef MQTT_HOST
+#define MQTT_HOST "homeassistant.local"
+#endif
+
+#ifndef MQTT_PORT
+#define MQTT_PORT 1883
+#endif
+
+#ifndef MQTT_USER
+#define MQTT_USER ""
+#endif
+
+#ifndef MQTT_PASSWORD
+#define MQTT_PASSWORD ""
+#endif
+
+// IRKs go to <prefix>/<mac>/irk, availability to <prefix>/status
+#ifndef MQTT_TOPIC_PREFIX
+#define MQTT_TOPIC_PREFIX "irk_finder"
+#endif
+
+#ifndef MQTT_DISCOVERY_PREFIX
+#define MQTT_DISCOVERY_PREFIX "homeassistant"
+#endif
+
+// Captures waiting for the broker; new captures are dropped when full
+#ifndef MQTT_QUEUE_LENGTH
+#define MQTT_QUEUE_LENGTH 32
+#endif
+
+// Captures published per publisher wake-up
+#ifndef MQTT_BATCH_SIZE
+#define MQTT_BATCH_SIZE 8
+#endif
+
+// Reconnect backoff, doubled after every failed attempt
+#ifndef MQTT_BACKOFF_MIN_MS
+#define MQTT_BACKOFF_MIN_MS 1000
+#endif
+
+#ifndef MQTT_BACKOFF_MAX_MS
+#define MQTT_BACKOFF_MAX_MS 60000
+#endif
+
+// UDP log shipper (requires WiFi station mode and USE_ESP_IDF_LOG, which
+// scripts/load_env.py adds when LOG_SHIP_ENABLED is set in .env)
+#ifndef LOG_SHIP_ENABLED
+#define LOG_SHIP_ENABLED 0
+#endif
+
+// Collector address or hostname
+#ifndef LOG_SHIP_HOST
+#define LOG_SHIP_HOST "192.168.1.10"
+#endif
+
+#ifndef LOG_SHIP_PORT
+#define LOG_SHIP_PORT 514
+#endif
+
+// 0 = RFC 5424 syslog, one message per datagram; 1 = JSON lines, packed
+#ifndef LOG_SHIP_FORMAT
+#define LOG_SHIP_FORMAT 0
+#endif
+
+// Most verbose esp_log level shipped: 1 = error ... 5 = verbose
+#ifndef LOG_SHIP_LEVEL
+#define LOG_SHIP_LEVEL 3
+#endif
+
+// Records waiting for the sender; new records are dropped and counted when
+// full. Each slot holds LOG_SHIP_LINE_MAX bytes plus 12.
+#ifndef LOG_SHIP_RING_SLOTS
+#define LOG_SHIP_RING_SLOTS 64
+#endif
+
+#ifndef LOG_SHIP_LINE_MAX
+#define LOG_SHIP_LINE_MAX 128
+#endif
+
+#ifndef LOG_SHIP_DATAGRAM_MAX
+#define LOG_SHIP_DATAGRAM_MAX 1400
+#endif
+
+// Sender wake-up interval; everything queued since goes out in one pass
+#ifndef LOG_SHIP_FLUSH_MS
+#define LOG_SHIP_FLUSH_MS 100
+#endif
+
+// Serial port baud rate
+#ifndef SERIAL_BAUD_RATE
+#define SERIAL_BAUD_RATE 115200
+#endif
+
+// Framed binary IRK protocol on the serial port (format in irk_frame.h).
+// Text banners are still printed; host readers skip them.
+#ifndef SERIAL_PROTOCOL_ENABLED
+#define SERIAL_PROTOCOL_ENABLED 0
+#endif
+
+// HTTP admission control (protects BLE pairing from web load): admitted
+// requests in flight at once, not connections
+#ifndef HTTP_MAX_CONCURRENT
+#define HTTP_MAX_CONCURRENT 4
+#endif
+
+// An admitted request still counted after this long is assumed gone
+#ifndef HTTP_IN_FLIGHT_MAX_MS
+#define HTTP_IN_FLIGHT_MAX_MS 30000
+#endif
+
+// Per-client token bucket: sustained requests per second and burst size
+#ifndef HTTP_RATE_PER_SEC
+#define HTTP_RATE_PER_SEC 5
+#endif
+
+#ifndef HTTP_RATE_BURST
+#define HTTP_RATE_BURST 10
+#endif
+
+// Number of client IPs tracked at once (least recently seen is recycled)
+#ifndef HTTP_RATE_CLIENTS
+#define HTTP_RATE_CLIENTS 8
+#endif
+
+// Retry-After (seconds) sent with 503 while a BLE pairing is in progress
+#ifndef HTTP_PAIRING_RETRY_AFTER
+#define HTTP_PAIRING_RETRY_AFTER 2
+#endif
+
+// Longest a stalled pairing may hold the web server off
+#ifndef HTTP_PAIRING_MAX_HOLD_MS
+#define HTTP_PAIRING_MAX_HOLD_MS 30000
+#endif
+
+// WiFi/BLE coexistence preference while a BLE link is pairing and while idle
+// 0 = prefer WiFi, 1 = prefer BLE, 2 = balanced (see coex_policy.h)
+#ifndef COEX_POLICY_PAIRING
+#define COEX_POLICY_PAIRING 1
+#endif
+
+#ifndef COEX_POLICY_IDLE
+#define COEX_POLICY_IDLE 2
+#endif
+
+// Largest accepted /api/wifi/save request body
+#ifndef WIFI_SAVE_BODY_MAX
+#define WIFI_SAVE_BODY_MAX 256
+#endif
+
+// POST /api/resolve: addresses per request, bonded IRKs considered, and the
+// recently-resolved address cache (slots must be a power of two)
+#ifndef RESOLVE_MAX_BATCH
+#define RESOLVE_MAX_BATCH 32
+#endif
+
+#ifndef RESOLVE_MAX_IRKS
+#define RESOLVE_MAX_IRKS 16
+#endif
+
+#ifndef RESOLVE_CACHE_SLOTS
+#define RESOLVE_CACHE_SLOTS 64
+#endif
+
+#ifndef RESOLVE_CACHE_TTL_MS
+#define RESOLVE_CACHE_TTL_MS 60000
+#endif
+
+// Resolve with mbedTLS (AES peripheral) instead of the portable AES
+#ifndef RESOLVE_HW_AES
+#define RESOLVE_HW_AES 1
+#endif
+
+// Measure the P-256 key pair and DHKey cost of Secure Connections pairing
+// once after boot, in a low-priority task (GET /api/pairing/stats)
+#ifndef SC_ECC_PROBE
+#define SC_ECC_PROBE 0
+#endif
+
+// The probe measures mbedTLS ECC (MPI accelerator); 0 leaves it nothing to
+// measure, for host builds without mbedTLS
+#ifndef SC_ECC_HW
+#define SC_ECC_HW 1
+#endif
+
+// Delay between answering a request and restarting, so the response flushes
+#ifndef RESTART_DELAY_MS
+#define RESTART_DELAY_MS 1000
+#endif
+
+// Firmware update at POST /api/ota. Needs a partition table with two OTA
+// app slots; without one the endpoint answers 501.
+#ifndef OTA_ENABLED
+#define OTA_ENABLED 1
+#endif
+
+// Value required in the X-OTA-Token header. While it is empty every upload
+// is refused (403), so a default build cannot be reflashed over the network.
+#ifndef OTA_TOKEN
+#define OTA_TOKEN ""
+#endif
+
+// An updated image that stays up this long is marked valid; a reset before
+// that boots the previous image (bootloader app rollback)
+#ifndef OTA_CONFIRM_MS
+#define OTA_CONFIRM_MS 30000
+#endif
+
+// Pending jobs held by the deferred job scheduler
+#ifndef DEFERRED_MAX_JOBS
+#define DEFERRED_MAX_JOBS 8
+#endif
+
+// WiFi scan cache for the configuration page
+#ifndef WIFI_SCAN_TTL_MS
+#define WIFI_SCAN_TTL_MS 30000
+#endif
+
+#ifndef WIFI_SCAN_MAX_RESULTS
+#define WIFI_SCAN_MAX_RESULTS 20
+#endif
+
+// Diagnostics endpoints (/api/debug/*, /api/tasks, /api/trace); on in the
+// esp32dev_bench env only
+#ifndef HTTP_DEBUG_ENDPOINTS
+#define HTTP_DEBUG_ENDPOINTS 0
+#endif
+
+// Ring of recent GAP/GATTS events served at /api/trace (power of two,
+// 12 bytes per entry); follows HTTP_DEBUG_ENDPOINTS, the only way to read it
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED HTTP_DEBUG_ENDPOINTS
+#endif
+
+#ifndef TRACE_RING_SIZE
+#define TRACE_RING_SIZE 256
+#endif
+
+// Task CPU monitor for /api/tasks, built with HTTP_DEBUG_ENDPOINTS: one sample
+// every TASK_MONITOR_SAMPLE_MS, CPU shares over the last TASK_MONITOR_WINDOW
+// samples
+#ifndef TASK_MONITOR_SAMPLE_MS
+#define TASK_MONITOR_SAMPLE_MS 1000
+#endif
+
+#ifndef TASK_MONITOR_WINDOW
+#define TASK_MONITOR_WINDOW 5
+#endif
+
+#ifndef TASK_MONITOR_MAX_TASKS
+#define TASK_MONITOR_MAX_TASKS 32
+#endif
+
+// GAP/GATTS callbacks running longer than this are logged and counted
+#ifndef BT_CALLBACK_BUDGET_US
+#define BT_CALLBACK_BUDGET_US 2000
+#endif
+
+// Task topology: core (-1 = no affinity) and priority of the tasks the
+// firmware creates. The board envs in platformio.ini override these. The
+// Bluedroid host task that runs the GAP/GATTS callbacks is placed by the
+// prebuilt sdkconfig, and AsyncTCP by CONFIG_ASYNC_TCP_RUNNING_CORE.
+#ifndef TASK_CORE_DEFERRED
+#define TASK_CORE_DEFERRED -1
+#endif
+
+#ifndef TASK_PRIO_DEFERRED
+#define TASK_PRIO_DEFERRED 1
+#endif
+
+#ifndef TASK_CORE_MQTT
+#define TASK_CORE_MQTT -1
+#endif
+
+#ifndef TASK_PRIO_MQTT
+#define TASK_PRIO_MQTT 1
+#endif
+
+#ifndef TASK_CORE_LOGSHIP
+#define TASK_CORE_LOGSHIP -1
+#endif
+
+#ifndef TASK_PRIO_LOGSHIP
+#define TASK_PRIO_LOGSHIP 1
+#endif
+
+// Captive portal DNS, served from its own task while in AP mode
+#ifndef TASK_CORE_DNS
+#define TASK_CORE_DNS -1
+#endif
+
+#ifndef TASK_PRIO_DNS
+#define TASK_PRIO_DNS 1
+#endif
+
+// Connection parameters requested for the duration of pairing (1.25 ms
+// units). The defaults are the shortest that iOS accepts (min >= 15 ms,
+// max >= min + 15 ms).
+#ifndef CONN_FAST_PAIRING
+#define CONN_FAST_PAIRING 1
+#endif
+
+#ifndef CONN_FAST_MIN_INTERVAL
+#define CONN_FAST_MIN_INTERVAL 0x0C
+#endif
+
+#ifndef CONN_FAST_MAX_INTERVAL
+#define CONN_FAST_MAX_INTERVAL 0x18
+#endif
+
+// Requested once pairing completes, unless the link is dropped instead
+#ifndef CONN_RELAXED_MIN_INTERVAL
+#define CONN_RELAXED_MIN_INTERVAL 0x18
+#endif
+
+#ifndef CONN_RELAXED_MAX_INTERVAL
+#define CONN_RELAXED_MAX_INTERVAL 0x28
+#endif
+
+#ifndef CONN_DISCONNECT_AFTER_PAIRING
+#define CONN_DISCONNECT_AFTER_PAIRING 0
+#endif
+
+// Supervision timeout in 10 ms units
+#ifndef CONN_SUPERVISION_TIMEOUT
+#define CONN_SUPERVISION_TIMEOUT 400
+#endif
+
+// Paired devices tracked by identity address (about 44 bytes of RAM each)
+#ifndef IRK_STORE_CAPACITY
+#define IRK_STORE_CAPACITY 16
+#endif
+
+// Largest page of GET /api/devices (up to 184 bytes of JSON per device)
+#ifndef DEVICES_PAGE_MAX
+#define DEVICES_PAGE_MAX 8
+#endif
+
 // LED Configuration (built-in LED on most ESP32 boards)
 #ifndef LED_PIN
 #define LED_PIN 2
@@ -0,0 +1,19 @@
+#ifndef CONN_PARAMS_H
+#define CONN_PARAMS_H
+
+#include "esp_gap_ble_api.h"
+
+// Connection-parameter policy around pairing: ask the central for a short
+// connection interval as soon as it connects so the SMP round trips and key
+// distribution finish sooner, then relax it (or disconnect) once pairing
+// is complete.
+
+void conn_params_on_connect(const esp_ble_gatts_cb_param_t::gatts_connect_evt_param& connect);
+void conn_params_on_paired(esp_bd_addr_t bda);
+void conn_params_on_update(const esp_ble_gap_cb_param_t::ble_update_conn_params_evt_param& update);
+
+// Runtime switch so pairing latency can be compared with and without it
+void conn_params_set_fast(bool enabled);
+bool conn_params_fast();
+
+#endif
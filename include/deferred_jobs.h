@@ -0,0 +1,20 @@
+#ifndef DEFERRED_JOBS_H
+#define DEFERRED_JOBS_H
+
+#include <stdint.h>
+
+// Small timed-job scheduler. Route handlers and BLE callbacks post work here
+// (restart after the response flushed, NVS writes, bond removal) and return
+// immediately instead of blocking their own task.
+
+typedef void (*deferred_job_fn_t)(void* arg);
+
+void deferred_jobs_begin();
+
+// Run fn(arg) on the scheduler task after delayMs, never earlier. Jobs with
+// the same due time run in posting order. Returns false if the job queue is
+// full (DEFERRED_MAX_JOBS pending plus as many queued); the caller keeps
+// ownership of arg in that case.
+bool deferred_post(deferred_job_fn_t fn, void* arg, uint32_t delayMs);
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef EVENT_TRACE_H
+#define EVENT_TRACE_H
+
+#include <stddef.h>
+#include "esp_gap_ble_api.h"
+#include "esp_gatts_api.h"
+#include "trace_json.h"
+
+// Always-on, fixed-size ring of every GAP and GATTS callback event with a
+// microsecond timestamp, connection id and status. Recording is a few
+// stores, no locks or allocation; the oldest entries are overwritten.
+// No-ops unless TRACE_ENABLED is set.
+
+void event_trace_gap(esp_gap_ble_cb_event_t event, const esp_ble_gap_cb_param_t* param);
+void event_trace_gatts(esp_gatts_cb_event_t event, const esp_ble_gatts_cb_param_t* param);
+
+// Copy the ring, oldest first, into out (up to max entries). Entries that
+// were overwritten while copying are left out.
+size_t event_trace_snapshot(TraceEvent* out, size_t max);
+uint32_t event_trace_total();           // events recorded since boot
+
+const char* event_trace_name(const TraceEvent& ev);
+TraceSpanEvents event_trace_spans();
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef HTTP_ADMISSION_H
+#define HTTP_ADMISSION_H
+
+#include <ESPAsyncWebServer.h>
+
+// Admission control for the web server so HTTP load cannot starve an SMP
+// exchange in progress: a cap on admitted requests in flight, per-client
+// token buckets, and 503 + Retry-After while a BLE pairing is active.
+//
+// The cap counts requests from admission until their connection closes. It
+// does not bound connections: routes that are not wrapped, rejected requests
+// and idle sockets hold connections without counting. Admission owns the
+// request's onDisconnect hook, so admitted handlers must not set their own.
+
+struct HttpAdmissionStats {
+    uint32_t admitted;
+    uint32_t rejectedBusy;      // too many in-flight requests
+    uint32_t rejectedRate;      // client exceeded its token bucket
+    uint32_t rejectedPairing;   // BLE pairing in progress
+    uint32_t expired;           // in-flight slots reclaimed without a disconnect
+    int inFlight;
+};
+
+// Called from the BLE callbacks on connect / auth complete / disconnect
+void http_admission_set_pairing(bool active);
+bool http_admission_pairing_active();
+
+// Wrap a route handler so it only runs for admitted requests
+ArRequestHandlerFunction admitted(ArRequestHandlerFunction handler);
+
+HttpAdmissionStats http_admission_stats();
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef IRK_FORMAT_H
+#define IRK_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A captured IRK with every output format rendered once, shared by the
+// serial, web and MQTT outputs
+struct IrkRecord {
+    uint8_t addr[6];            // address the IRK was reported under
+    uint8_t identity[6];        // identity address from the PID key
+    uint8_t addrType;
+    uint8_t irk[16];
+    char mac[18];               // identity address, AA:BB:CC:DD:EE:FF
+    char hex[33];
+    char reversed[33];          // byte-reversed, for ESPresense
+    char base64[25];            // for Home Assistant Private BLE Device
+    char array[80];             // 0x11,0x22,...
+};
+
+void irk_format_record(IrkRecord& record);
+
+#endif
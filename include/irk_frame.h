@@ -0,0 +1,176 @@
+#ifndef IRK_FRAME_H
+#define IRK_FRAME_H
+
+/*
+ * Binary frame format for the serial IRK link.
+ *
+ *   0xA5 0x5A | type (1) | length (2, LE) | payload (length) | CRC16 (2, LE)
+ *
+ * The CRC is CRC-16/CCITT-FALSE over type, length and payload. Frames may be
+ * interleaved with plain-text log output; the parser skips anything that is
+ * not a complete frame with a valid CRC.
+ *
+ * This header has no Arduino dependencies so the host-side reader in
+ * tools/irk-reader uses the exact same codec.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace irkframe {
+
+static const uint8_t SYNC0 = 0xA5;
+static const uint8_t SYNC1 = 0x5A;
+static const size_t HEADER_SIZE = 5;      // sync (2) + type (1) + length (2)
+static const size_t TRAILER_SIZE = 2;     // CRC16
+static const size_t MAX_PAYLOAD = 64;
+static const size_t MAX_FRAME = HEADER_SIZE + MAX_PAYLOAD + TRAILER_SIZE;
+
+// Device -> host events
+enum EventType : uint8_t {
+    EVT_IRK_CAPTURED = 0x01,   // addr[6], addr_type, irk[16]
+    EVT_BOND_REMOVED = 0x02,   // addr[6] (all zero = every bond)
+    EVT_STATUS       = 0x03,   // uptime_ms u32, free_heap u32, bonds u8, irk_retrieved u8
+    EVT_BOND_ENTRY   = 0x04,   // addr[6], addr_type
+    EVT_LIST_END     = 0x05,   // count u8
+    EVT_ACK          = 0x06,   // command type u8, status u8 (0 = ok)
+};
+
+// Host -> device commands
+enum CommandType : uint8_t {
+    CMD_RESET  = 0x81,         // remove all bonds and clear the current IRK
+    CMD_LIST   = 0x82,         // EVT_BOND_ENTRY per bond with an IRK, then EVT_LIST_END
+    CMD_EXPORT = 0x83,         // EVT_IRK_CAPTURED per bond with an IRK, then EVT_LIST_END
+    CMD_STATUS = 0x84,         // EVT_STATUS
+};
+
+static const size_t IRK_CAPTURED_SIZE = 23;
+static const size_t BOND_REMOVED_SIZE = 6;
+static const size_t STATUS_SIZE = 10;
+static const size_t BOND_ENTRY_SIZE = 7;
+
+inline uint16_t crc16(const uint8_t* data, size_t len, uint16_t crc = 0xFFFF) {
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+inline void putU16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+inline void putU32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+inline uint16_t getU16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+inline uint32_t getU32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Encode a frame into out. Returns the frame size, or 0 if it does not fit.
+inline size_t encode(uint8_t type, const uint8_t* payload, size_t len, uint8_t* out, size_t cap) {
+    if (len > MAX_PAYLOAD || cap < HEADER_SIZE + len + TRAILER_SIZE) {
+        return 0;
+    }
+    out[0] = SYNC0;
+    out[1] = SYNC1;
+    out[2] = type;
+    putU16(&out[3], (uint16_t)len);
+    if (len > 0) {
+        memcpy(&out[HEADER_SIZE], payload, len);
+    }
+    putU16(&out[HEADER_SIZE + len], crc16(&out[2], 3 + len));
+    return HEADER_SIZE + len + TRAILER_SIZE;
+}
+
+// Incremental parser. Feed bytes one at a time; feed() returns true when a
+// complete, CRC-valid frame is available through type()/payload()/length().
+class Parser {
+public:
+    Parser() { reset(); }
+
+    void reset() {
+        state_ = WAIT_SYNC0;
+        pos_ = 0;
+    }
+
+    bool feed(uint8_t byte) {
+        switch (state_) {
+            case WAIT_SYNC0:
+                if (byte == SYNC0) state_ = WAIT_SYNC1;
+                return false;
+
+            case WAIT_SYNC1:
+                if (byte == SYNC1) {
+                    state_ = READ_HEADER;
+                    pos_ = 0;
+                } else if (byte != SYNC0) {
+                    state_ = WAIT_SYNC0;
+                }
+                return false;
+
+            case READ_HEADER:
+                buf_[pos_++] = byte;
+                if (pos_ == 3) {
+                    len_ = getU16(&buf_[1]);
+                    if (len_ > MAX_PAYLOAD) {
+                        oversized_++;
+                        reset();
+                        return false;
+                    }
+                    state_ = READ_BODY;
+                }
+                return false;
+
+            case READ_BODY:
+                buf_[pos_++] = byte;
+                if (pos_ < 3 + len_ + TRAILER_SIZE) {
+                    return false;
+                }
+                state_ = WAIT_SYNC0;
+                if (crc16(buf_, 3 + len_) != getU16(&buf_[3 + len_])) {
+                    crcErrors_++;
+                    return false;
+                }
+                frames_++;
+                return true;
+        }
+        return false;
+    }
+
+    uint8_t type() const { return buf_[0]; }
+    uint16_t length() const { return len_; }
+    const uint8_t* payload() const { return &buf_[3]; }
+
+    uint32_t frames() const { return frames_; }
+    uint32_t crcErrors() const { return crcErrors_; }
+    uint32_t oversized() const { return oversized_; }
+
+private:
+    enum State { WAIT_SYNC0, WAIT_SYNC1, READ_HEADER, READ_BODY };
+
+    State state_;
+    size_t pos_;
+    uint16_t len_ = 0;
+    uint8_t buf_[3 + MAX_PAYLOAD + TRAILER_SIZE];
+    uint32_t frames_ = 0;
+    uint32_t crcErrors_ = 0;
+    uint32_t oversized_ = 0;
+};
+
+}  // namespace irkframe
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef IRK_INDEX_H
+#define IRK_INDEX_H
+
+#include <stdint.h>
+#include "irk_store.h"
+
+// Devices paired since boot (and bonds found in NVS), keyed by identity
+// address and IRK so a phone pairing again updates its existing record.
+// Safe to call from the BLE callbacks, the loop task and web handlers.
+
+void irk_index_begin();
+
+// Returns the upsert result; *record receives a copy of the stored entry
+irkstore::UpsertResult irk_index_record(const uint8_t* addr, uint8_t addrType, const uint8_t* irk,
+                                        irkstore::Record* record);
+
+// Add an existing bond without counting a pairing; no-op if already known
+void irk_index_seed(const uint8_t* addr, uint8_t addrType, const uint8_t* irk);
+
+bool irk_index_find(const uint8_t* addr, irkstore::Record* record);
+bool irk_index_remove(const uint8_t* addr);
+void irk_index_clear();
+uint16_t irk_index_count();
+
+// One page of records in identity address order, after the cursor address
+// `after` (NULL for the first page). A non-empty query keeps only records
+// whose address or IRK hex contains it, in either case. Returns the number
+// copied to out; *more is set if further matching records follow.
+uint16_t irk_index_page(const uint8_t* after, const char* query, irkstore::Record* out, uint16_t max,
+                        bool* more);
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef IRK_PUBLISH_H
+#define IRK_PUBLISH_H
+
+#include <stdint.h>
+#include "irk_format.h"
+
+// Single publication stage for captured IRKs. Every capture path (key
+// exchange, bond list) hands in the raw key; captures are de-duplicated by
+// IRK content, and only a new IRK is formatted and passed to the sink,
+// which notifies every output once.
+
+struct IrkPublishStats {
+    uint32_t captures;          // raw capture events handed in
+    uint32_t duplicates;        // dropped, IRK already published
+    uint32_t formatted;         // records rendered to text
+    uint32_t published;         // records passed to the sink
+};
+
+typedef void (*irk_publish_sink_t)(const IrkRecord& record, bool fromKeyExchange);
+
+void irk_publish_begin(irk_publish_sink_t sink);
+
+// Returns true if the IRK was new and has been published
+bool irk_publish(const uint8_t* addr, const uint8_t* identity, uint8_t addrType, const uint8_t* irk,
+                 bool fromKeyExchange);
+
+// Forget what was published, e.g. after the bonds have been cleared
+void irk_publish_reset();
+
+// Forget one IRK, so the device is published again if it pairs again
+void irk_publish_forget(const uint8_t* irk);
+
+IrkPublishStats irk_publish_stats();
+
+#endif
@@ -0,0 +1,272 @@
+#ifndef IRK_STORE_H
+#define IRK_STORE_H
+
+/*
+ * Fixed-capacity store of paired devices, indexed by identity address and by
+ * IRK.
+ *
+ * Records live in a dense array. Two open-addressed tables (linear probing,
+ * twice the capacity, backward-shift deletion so there are no tombstones) map
+ * the identity address and the IRK to a record. Insert, lookup, update and
+ * remove are O(1) on average and nothing is allocated after construction.
+ *
+ * No Arduino dependencies, so tools/bench uses the same code.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace irkstore {
+
+struct Record {
+    uint8_t addr[6];            // identity address
+    uint8_t addrType;           // 0 = public, 1 = random static
+    uint8_t irk[16];
+    uint32_t firstSeenMs;
+    uint32_t lastSeenMs;
+    uint16_t pairCount;
+};
+
+enum UpsertResult {
+    INSERTED,                   // new device
+    UPDATED,                    // known device paired again
+    FULL,                       // new device, no room left
+};
+
+// FNV-1a; both keys are short and the IRK is already random
+inline uint32_t hashBytes(const uint8_t* data, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= data[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Smallest power of two >= n
+constexpr uint32_t tableSize(uint32_t n, uint32_t p = 1) {
+    return p >= n ? p : tableSize(n, p * 2);
+}
+
+template <uint16_t Capacity>
+class Store {
+    static_assert(Capacity > 0 && Capacity < 32768, "Capacity must fit the 16-bit index");
+
+public:
+    Store() { clear(); }
+
+    void clear() {
+        count_ = 0;
+        memset(byAddr_, 0, sizeof(byAddr_));
+        memset(byIrk_, 0, sizeof(byIrk_));
+    }
+
+    // Record a pairing. A known identity address or a known IRK updates the
+    // existing record in place; anything else is inserted. If the address
+    // and the IRK belong to two different records, the IRK's record is
+    // merged into the address's, so an IRK never maps to two devices.
+    UpsertResult upsert(const uint8_t* addr, uint8_t addrType, const uint8_t* irk, uint32_t nowMs,
+                        const Record** out = NULL) {
+        int idx = findAddr(addr);
+        if (idx < 0) idx = findIrk(irk);
+
+        if (idx >= 0) {
+            int other = findIrk(irk);
+            if (other >= 0 && other != idx) {
+                const Record& o = records_[other];
+                Record& keep = records_[idx];
+                if ((int32_t)(o.firstSeenMs - keep.firstSeenMs) < 0) keep.firstSeenMs = o.firstSeenMs;
+                uint32_t pairs = (uint32_t)keep.pairCount + o.pairCount;
+                keep.pairCount = pairs < 0xFFFF ? (uint16_t)pairs : 0xFFFF;
+                removeAt((uint16_t)other);
+                // The removal moves the last record into the hole, which may
+                // be this one
+                idx = findAddr(addr);
+            }
+
+            Record& r = records_[idx];
+            if (memcmp(r.addr, addr, 6) != 0) {
+                unlink(byAddr_, r.addr, 6, (uint16_t)idx);
+                memcpy(r.addr, addr, 6);
+                link(byAddr_, r.addr, 6, (uint16_t)idx);
+            }
+            if (memcmp(r.irk, irk, 16) != 0) {
+                unlink(byIrk_, r.irk, 16, (uint16_t)idx);
+                memcpy(r.irk, irk, 16);
+                link(byIrk_, r.irk, 16, (uint16_t)idx);
+            }
+            r.addrType = addrType;
+            r.lastSeenMs = nowMs;
+            if (r.pairCount < 0xFFFF) r.pairCount++;
+            if (out) *out = &r;
+            return UPDATED;
+        }
+
+        if (count_ >= Capacity) {
+            if (out) *out = NULL;
+            return FULL;
+        }
+
+        uint16_t slot = count_++;
+        Record& r = records_[slot];
+        memcpy(r.addr, addr, 6);
+        r.addrType = addrType;
+        memcpy(r.irk, irk, 16);
+        r.firstSeenMs = nowMs;
+        r.lastSeenMs = nowMs;
+        r.pairCount = 1;
+        link(byAddr_, r.addr, 6, slot);
+        link(byIrk_, r.irk, 16, slot);
+        if (out) *out = &r;
+        return INSERTED;
+    }
+
+    // Insert a device known from elsewhere (e.g. an existing bond) without
+    // counting it as a pairing. Returns false if it is already present or
+    // the store is full.
+    bool seed(const uint8_t* addr, uint8_t addrType, const uint8_t* irk, uint32_t nowMs) {
+        if (findAddr(addr) >= 0 || findIrk(irk) >= 0 || count_ >= Capacity) return false;
+        const Record* r = NULL;
+        upsert(addr, addrType, irk, nowMs, &r);
+        records_[r - records_].pairCount = 0;
+        return true;
+    }
+
+    const Record* findByAddr(const uint8_t* addr) const {
+        int idx = findAddr(addr);
+        return idx < 0 ? NULL : &records_[idx];
+    }
+
+    const Record* findByIrk(const uint8_t* irk) const {
+        int idx = findIrk(irk);
+        return idx < 0 ? NULL : &records_[idx];
+    }
+
+    // Remove by identity address. The last record moves into the hole so the
+    // array stays dense; record order is not stable across removals.
+    bool remove(const uint8_t* addr) {
+        int idx = findAddr(addr);
+        if (idx < 0) return false;
+        removeAt((uint16_t)idx);
+        return true;
+    }
+
+    // Copy up to max records whose identity address sorts after `after`
+    // (NULL: from the first) into out, in ascending address order, skipping
+    // records that match() rejects. The address is the cursor, so paging
+    // stays consistent while records are added or removed between pages.
+    // Returns the number copied; *more is set if matching records remain.
+    template <typename Match>
+    uint16_t page(const uint8_t* after, Record* out, uint16_t max, bool* more, Match match) const {
+        uint16_t n = 0;
+        uint16_t eligible = 0;
+        for (uint16_t i = 0; i < count_; i++) {
+            const Record& r = records_[i];
+            if (after && memcmp(r.addr, after, 6) <= 0) continue;
+            if (!match(r)) continue;
+            eligible++;
+            if (n == max && (max == 0 || memcmp(r.addr, out[n - 1].addr, 6) > 0)) continue;
+
+            // Insertion into the sorted page, dropping its last entry when full
+            uint16_t j = n < max ? n++ : n - 1;
+            while (j > 0 && memcmp(out[j - 1].addr, r.addr, 6) > 0) {
+                out[j] = out[j - 1];
+                j--;
+            }
+            out[j] = r;
+        }
+        if (more) *more = eligible > n;
+        return n;
+    }
+
+    uint16_t page(const uint8_t* after, Record* out, uint16_t max, bool* more) const {
+        return page(after, out, max, more, [](const Record&) { return true; });
+    }
+
+    uint16_t size() const { return count_; }
+    static constexpr uint16_t capacity() { return Capacity; }
+    const Record& at(uint16_t i) const { return records_[i]; }
+
+private:
+    // Index tables hold record index + 1; 0 marks an empty slot
+    static constexpr uint32_t TABLE_SIZE = tableSize(Capacity * 2u);
+    static constexpr uint32_t MASK = TABLE_SIZE - 1;
+
+    void removeAt(uint16_t hole) {
+        unlink(byAddr_, records_[hole].addr, 6, hole);
+        unlink(byIrk_, records_[hole].irk, 16, hole);
+
+        uint16_t last = --count_;
+        if (hole != last) {
+            Record& moved = records_[last];
+            relink(byAddr_, moved.addr, 6, last, hole);
+            relink(byIrk_, moved.irk, 16, last, hole);
+            records_[hole] = moved;
+        }
+    }
+
+    int findAddr(const uint8_t* addr) const {
+        return find(byAddr_, addr, 6);
+    }
+
+    int findIrk(const uint8_t* irk) const {
+        return find(byIrk_, irk, 16);
+    }
+
+    // Key of a record in the given table
+    const uint8_t* keyOf(const uint16_t* table, const Record& r) const {
+        return table == byAddr_ ? r.addr : r.irk;
+    }
+
+    int find(const uint16_t* table, const uint8_t* key, size_t len) const {
+        uint32_t pos = hashBytes(key, len) & MASK;
+        while (table[pos] != 0) {
+            uint16_t idx = table[pos] - 1;
+            if (memcmp(keyOf(table, records_[idx]), key, len) == 0) return idx;
+            pos = (pos + 1) & MASK;
+        }
+        return -1;
+    }
+
+    void link(uint16_t* table, const uint8_t* key, size_t len, uint16_t idx) {
+        uint32_t pos = hashBytes(key, len) & MASK;
+        while (table[pos] != 0) pos = (pos + 1) & MASK;
+        table[pos] = idx + 1;
+    }
+
+    // Point the entry for key at a new record index
+    void relink(uint16_t* table, const uint8_t* key, size_t len, uint16_t from, uint16_t to) {
+        uint32_t pos = hashBytes(key, len) & MASK;
+        while (table[pos] != from + 1) pos = (pos + 1) & MASK;
+        table[pos] = to + 1;
+    }
+
+    // Delete the entry for key and shift later entries of the probe run back
+    void unlink(uint16_t* table, const uint8_t* key, size_t len, uint16_t idx) {
+        uint32_t pos = hashBytes(key, len) & MASK;
+        while (table[pos] != idx + 1) pos = (pos + 1) & MASK;
+
+        uint32_t hole = pos;
+        uint32_t next = (hole + 1) & MASK;
+        while (table[next] != 0) {
+            uint32_t home = hashBytes(keyOf(table, records_[table[next] - 1]), len) & MASK;
+            // Move the entry if its home slot is not in (hole, next]
+            if (((next - home) & MASK) >= ((next - hole) & MASK)) {
+                table[hole] = table[next];
+                hole = next;
+            }
+            next = (next + 1) & MASK;
+        }
+        table[hole] = 0;
+    }
+
+    Record records_[Capacity];
+    uint16_t byAddr_[TABLE_SIZE];
+    uint16_t byIrk_[TABLE_SIZE];
+    uint16_t count_;
+};
+
+}  // namespace irkstore
+
+#endif
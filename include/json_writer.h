@@ -0,0 +1,230 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+/*
+ * Streaming JSON writer
+ *
+ * Serializes straight into any sink with write(const uint8_t*, size_t) - an
+ * AsyncResponseStream, or the fixed BufferOut below - without building an
+ * intermediate String. Strings are escaped. Commas are inserted
+ * automatically.
+ *
+ * The jsonsize helpers give compile-time upper bounds for a document, used
+ * to size the response buffer once so it never reallocates.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace jsonsize {
+
+// "key": plus the separating comma
+template <size_t N>
+constexpr size_t key(const char (&)[N]) { return (N - 1) + 4; }
+// Quoted string of up to maxLen bytes, every byte escaped as \u00XX
+constexpr size_t str(size_t maxLen) { return maxLen * 6 + 2; }
+// Quoted string that never needs escaping (hex, base64, addresses)
+constexpr size_t plain(size_t maxLen) { return maxLen + 2; }
+constexpr size_t boolean() { return 5; }
+constexpr size_t u32() { return 10; }
+constexpr size_t i32() { return 11; }
+constexpr size_t ipv4() { return plain(15); }
+// Braces of an object or array
+constexpr size_t braces() { return 2; }
+
+}  // namespace jsonsize
+
+// Fixed-size sink over a caller-owned char buffer. Output past the end is
+// dropped and flagged; the buffer is always NUL-terminated.
+class BufferOut {
+public:
+    BufferOut(char* buf, size_t cap) : buf_(buf), cap_(cap), len_(0), overflow_(false) {
+        if (cap_ > 0) buf_[0] = '\0';
+    }
+
+    size_t write(const uint8_t* data, size_t n) {
+        if (cap_ == 0) {
+            overflow_ = true;
+            return 0;
+        }
+        size_t room = cap_ - 1 - len_;
+        if (n > room) {
+            n = room;
+            overflow_ = true;
+        }
+        memcpy(buf_ + len_, data, n);
+        len_ += n;
+        buf_[len_] = '\0';
+        return n;
+    }
+
+    const char* c_str() const { return buf_; }
+    size_t length() const { return len_; }
+    bool overflow() const { return overflow_; }
+
+private:
+    char* buf_;
+    size_t cap_;
+    size_t len_;
+    bool overflow_;
+};
+
+template <typename Out>
+class JsonWriter {
+public:
+    explicit JsonWriter(Out& out) : out_(out), depth_(0), first_(1) {}
+
+    JsonWriter& beginObject() { open('{'); return *this; }
+    JsonWriter& endObject() { close('}'); return *this; }
+    JsonWriter& beginArray() { open('['); return *this; }
+    JsonWriter& endArray() { close(']'); return *this; }
+
+    JsonWriter& key(const char* k) {
+        separator();
+        quoted(k, strlen(k));
+        raw(":", 1);
+        afterKey_ = true;
+        return *this;
+    }
+
+    JsonWriter& value(const char* s) {
+        if (!s) return null();
+        return value(s, strlen(s));
+    }
+
+    JsonWriter& value(const char* s, size_t len) {
+        separator();
+        quoted(s, len);
+        return *this;
+    }
+
+    JsonWriter& value(bool b) {
+        separator();
+        if (b) raw("true", 4);
+        else raw("false", 5);
+        return *this;
+    }
+
+    JsonWriter& value(long v) {
+        char num[21];
+        int n = snprintf(num, sizeof(num), "%ld", v);
+        separator();
+        raw(num, (size_t)n);
+        return *this;
+    }
+
+    JsonWriter& value(unsigned long v) {
+        char num[21];
+        int n = snprintf(num, sizeof(num), "%lu", v);
+        separator();
+        raw(num, (size_t)n);
+        return *this;
+    }
+
+    // int32_t/uint32_t are int or long depending on the toolchain; cover both
+    JsonWriter& value(int v) { return value((long)v); }
+    JsonWriter& value(unsigned int v) { return value((unsigned long)v); }
+
+    JsonWriter& null() {
+        separator();
+        raw("null", 4);
+        return *this;
+    }
+
+    // Dotted-quad IPv4 address from its four octets
+    JsonWriter& ipv4(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+        char ip[16];
+        int n = snprintf(ip, sizeof(ip), "%u.%u.%u.%u", a, b, c, d);
+        return value(ip, (size_t)n);
+    }
+
+    // Lowercase hex string of a byte array
+    JsonWriter& hex(const uint8_t* data, size_t len) {
+        static const char digits[] = "0123456789abcdef";
+        separator();
+        raw("\"", 1);
+        for (size_t i = 0; i < len; i++) {
+            char pair[2] = {digits[data[i] >> 4], digits[data[i] & 0x0F]};
+            raw(pair, 2);
+        }
+        raw("\"", 1);
+        return *this;
+    }
+
+    template <typename T>
+    JsonWriter& field(const char* k, T v) {
+        key(k);
+        return value(v);
+    }
+
+private:
+    void raw(const char* s, size_t n) {
+        out_.write(reinterpret_cast<const uint8_t*>(s), n);
+    }
+
+    void open(char c) {
+        separator();
+        raw(&c, 1);
+        depth_++;
+        first_ |= (1UL << depth_);
+    }
+
+    void close(char c) {
+        raw(&c, 1);
+        first_ &= ~(1UL << depth_);
+        depth_--;
+    }
+
+    // Emit a comma unless this is the first element at this level or the
+    // value that follows a key
+    void separator() {
+        if (afterKey_) {
+            afterKey_ = false;
+            return;
+        }
+        if (first_ & (1UL << depth_)) {
+            first_ &= ~(1UL << depth_);
+        } else {
+            raw(",", 1);
+        }
+    }
+
+    void quoted(const char* s, size_t len) {
+        raw("\"", 1);
+        size_t start = 0;
+        for (size_t i = 0; i < len; i++) {
+            unsigned char c = (unsigned char)s[i];
+            const char* esc = NULL;
+            char buf[7];
+            switch (c) {
+                case '"': esc = "\\\""; break;
+                case '\\': esc = "\\\\"; break;
+                case '\n': esc = "\\n"; break;
+                case '\r': esc = "\\r"; break;
+                case '\t': esc = "\\t"; break;
+                default:
+                    if (c < 0x20) {
+                        snprintf(buf, sizeof(buf), "\\u%04x", c);
+                        esc = buf;
+                    }
+                    break;
+            }
+            if (esc) {
+                if (i > start) raw(s + start, i - start);
+                raw(esc, strlen(esc));
+                start = i + 1;
+            }
+        }
+        if (len > start) raw(s + start, len - start);
+        raw("\"", 1);
+    }
+
+    Out& out_;
+    uint8_t depth_;
+    uint32_t first_;        // bit n set: no element written yet at depth n
+    bool afterKey_ = false;
+};
+
+#endif
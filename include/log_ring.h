@@ -0,0 +1,220 @@
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+/*
+ * Bounded log record ring and the two wire formats of the log shipper.
+ *
+ * Records are copied into fixed slots, so pushing never allocates; when the
+ * ring is full the new record is dropped and counted. Every offered record
+ * takes the next sequence number, dropped or not, so a collector sees drops
+ * as gaps. The ring does no locking; the caller serializes push and pop.
+ *
+ * Wire formats, one record per call:
+ *   RFC 5424 syslog  <134>1 - host irk-finder - LOG [meta sequenceId="7" sysUpTime="123"] GATTS: text
+ *   JSON lines       {"seq":7,"ms":1234,"host":"host","type":"log","level":"I","tag":"GATTS","msg":"text"}
+ *
+ * No Arduino dependencies, so tools/bench uses the same code.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "json_writer.h"
+
+namespace logring {
+
+enum Kind : uint8_t {
+    KIND_LOG,                   // an esp_log line
+    KIND_IRK,                   // text is "<mac> <irk hex> <source>"
+    KIND_DROP,                  // text is the number of records dropped
+};
+
+template <uint16_t LineMax>
+struct Slot {
+    uint32_t seq;
+    uint32_t ms;
+    uint8_t kind;
+    uint8_t len;
+    char text[LineMax];
+};
+
+template <uint16_t Slots, uint16_t LineMax>
+class Ring {
+    static_assert(Slots > 0, "Ring needs at least one slot");
+    static_assert(LineMax > 1 && LineMax <= 256, "Line length must fit the 8-bit length");
+
+public:
+    typedef Slot<LineMax> Entry;
+
+    Ring() : head_(0), count_(0), seq_(0), pushed_(0), dropped_(0) {}
+
+    // Copies up to LineMax - 1 bytes of text; false if the ring was full
+    bool push(uint32_t ms, uint8_t kind, const char* text, size_t len) {
+        uint32_t seq = ++seq_;
+        if (count_ == Slots) {
+            dropped_++;
+            return false;
+        }
+        Entry& e = slots_[(head_ + count_) % Slots];
+        if (len > LineMax - 1) len = LineMax - 1;
+        e.seq = seq;
+        e.ms = ms;
+        e.kind = kind;
+        e.len = (uint8_t)len;
+        memcpy(e.text, text, len);
+        e.text[len] = '\0';
+        count_++;
+        pushed_++;
+        return true;
+    }
+
+    bool pop(Entry& out) {
+        if (count_ == 0) return false;
+        out = slots_[head_];
+        head_ = (head_ + 1) % Slots;
+        count_--;
+        return true;
+    }
+
+    uint16_t size() const { return count_; }
+    uint32_t pushed() const { return pushed_; }
+    uint32_t dropped() const { return dropped_; }
+
+private:
+    Entry slots_[Slots];
+    uint16_t head_;
+    uint16_t count_;
+    uint32_t seq_;
+    uint32_t pushed_;
+    uint32_t dropped_;
+};
+
+// An esp_log line split into its parts: "I (1234) TAG: message", possibly
+// wrapped in ANSI colour codes. Anything else is kept whole as the message.
+struct LogLine {
+    char level;                 // E, W, I, D, V
+    const char* tag;
+    size_t tagLen;
+    const char* msg;
+    size_t msgLen;
+};
+
+inline LogLine parseLogLine(const char* text, size_t len) {
+    const char* p = text;
+    const char* end = text + len;
+    // Colour prefix "\033[0;32m"
+    if (p < end && *p == '\033') {
+        while (p < end && *p != 'm') p++;
+        if (p < end) p++;
+    }
+    // Trailing newline and colour reset, in either order
+    for (;;) {
+        if (end > p && (end[-1] == '\n' || end[-1] == '\r')) end--;
+        else if (end - p >= 4 && memcmp(end - 4, "\033[0m", 4) == 0) end -= 4;
+        else break;
+    }
+
+    LogLine line = {'I', "-", 1, p, (size_t)(end - p)};
+    if (end - p < 4 || !strchr("EWIDV", p[0]) || p[1] != ' ' || p[2] != '(') return line;
+
+    const char* tag = (const char*)memchr(p, ')', end - p);
+    if (!tag || tag + 2 > end || tag[1] != ' ') return line;
+    tag += 2;
+    const char* colon = tag;
+    while (colon + 1 < end && !(colon[0] == ':' && colon[1] == ' ')) colon++;
+    if (colon + 1 >= end) return line;
+
+    line.level = p[0];
+    line.tag = tag;
+    line.tagLen = (size_t)(colon - tag);
+    line.msg = colon + 2;
+    line.msgLen = (size_t)(end - line.msg);
+    return line;
+}
+
+// RFC 5424 severity of an esp_log level letter
+inline uint8_t severity(char level) {
+    switch (level) {
+        case 'E': return 3;
+        case 'W': return 4;
+        case 'I': return 6;
+        default: return 7;
+    }
+}
+
+// One RFC 5424 message. Without a clock the TIMESTAMP is NILVALUE; uptime
+// and sequence number go in the registered "meta" SD-ID. Returns the length
+// written, or 0 if it does not fit.
+template <uint16_t LineMax>
+size_t formatSyslog(const Slot<LineMax>& e, const char* host, uint8_t facility, char* out, size_t cap) {
+    char level = 'I';
+    const char* msgId = "LOG";
+    const char* body = e.text;
+    size_t bodyLen = e.len;
+    char tagged[LineMax + 40];
+
+    if (e.kind == KIND_LOG) {
+        LogLine line = parseLogLine(e.text, e.len);
+        level = line.level;
+        int n = snprintf(tagged, sizeof(tagged), "%.*s: %.*s", (int)line.tagLen, line.tag,
+                         (int)line.msgLen, line.msg);
+        body = tagged;
+        bodyLen = n < 0 ? 0 : ((size_t)n < sizeof(tagged) ? (size_t)n : sizeof(tagged) - 1);
+    } else if (e.kind == KIND_IRK) {
+        msgId = "IRK";
+    } else {
+        level = 'W';
+        msgId = "DROP";
+        int n = snprintf(tagged, sizeof(tagged), "dropped %.*s records", (int)e.len, e.text);
+        body = tagged;
+        bodyLen = n < 0 ? 0 : (size_t)n;
+    }
+
+    int n = snprintf(out, cap, "<%u>1 - %s irk-finder - %s [meta sequenceId=\"%lu\" sysUpTime=\"%lu\"] %.*s",
+                     (unsigned)(facility * 8 + severity(level)), host, msgId, (unsigned long)e.seq,
+                     (unsigned long)(e.ms / 10), (int)bodyLen, body);
+    return (n < 0 || (size_t)n >= cap) ? 0 : (size_t)n;
+}
+
+// One JSON line, newline included. Returns the length written, or 0 if it
+// does not fit.
+template <uint16_t LineMax>
+size_t formatJson(const Slot<LineMax>& e, const char* host, char* out, size_t cap) {
+    BufferOut buf(out, cap);
+    JsonWriter<BufferOut> json(buf);
+    json.beginObject();
+    json.field("seq", (unsigned long)e.seq);
+    json.field("ms", (unsigned long)e.ms);
+    json.field("host", host);
+    if (e.kind == KIND_LOG) {
+        LogLine line = parseLogLine(e.text, e.len);
+        char level[2] = {line.level, '\0'};
+        json.field("type", "log");
+        json.field("level", level);
+        json.key("tag").value(line.tag, line.tagLen);
+        json.key("msg").value(line.msg, line.msgLen);
+    } else if (e.kind == KIND_IRK) {
+        // "<mac> <irk> <source>"
+        const char* irk = (const char*)memchr(e.text, ' ', e.len);
+        const char* source = irk ? (const char*)memchr(irk + 1, ' ', e.text + e.len - irk - 1) : NULL;
+        json.field("type", "irk");
+        if (irk && source) {
+            json.key("mac").value(e.text, (size_t)(irk - e.text));
+            json.key("irk").value(irk + 1, (size_t)(source - irk - 1));
+            json.key("source").value(source + 1, (size_t)(e.text + e.len - source - 1));
+        }
+    } else {
+        json.field("type", "drop");
+        json.field("count", strtoul(e.text, NULL, 10));
+    }
+    json.endObject();
+    buf.write((const uint8_t*)"\n", 1);
+    return buf.overflow() ? 0 : buf.length();
+}
+
+}  // namespace logring
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef LOG_SHIPPER_H
+#define LOG_SHIPPER_H
+
+#include <stdint.h>
+#include "irk_format.h"
+
+// Ships esp_log output and captured IRKs to a UDP collector as RFC 5424
+// syslog or JSON lines (formats in log_ring.h). Records go through a bounded
+// ring: callers copy a line in and return, a full ring drops the record and
+// the count is sent on as a drop record.
+// Every function is a no-op unless LOG_SHIP_ENABLED is set.
+
+struct LogShipperStats {
+    uint32_t queued;
+    uint32_t dropped;           // ring full at enqueue time
+    uint32_t sent;              // records handed to the network
+    uint32_t datagrams;
+    uint32_t sendErrors;
+    bool connected;             // WiFi up and collector resolved
+    bool benchRunning;
+};
+
+void log_shipper_begin(const char* hostname);
+bool log_shipper_enqueue_irk(const IrkRecord& record, bool fromKeyExchange);
+LogShipperStats log_shipper_stats();
+
+// Offer `rate` synthetic records per second for `seconds` straight to the
+// ring, to measure throughput at the collector. False if one is running.
+bool log_shipper_bench(uint32_t rate, uint32_t seconds);
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef MQTT_PUBLISHER_H
+#define MQTT_PUBLISHER_H
+
+#include <stdint.h>
+#include "irk_format.h"
+
+// Publishes captured IRKs to an MQTT broker as retained per-device topics,
+// plus Home Assistant discovery. All broker I/O runs on its own task; callers
+// only push into a bounded queue and never block.
+// Every function is a no-op unless MQTT_ENABLED is set.
+
+struct MqttPublisherStats {
+    uint32_t queued;
+    uint32_t dropped;      // queue full at enqueue time
+    uint32_t coalesced;    // superseded by a newer capture in the same batch
+    uint32_t published;
+    uint32_t batches;
+    uint32_t reconnects;
+    bool connected;
+};
+
+void mqtt_publisher_begin();
+bool mqtt_publisher_enqueue_irk(const IrkRecord& record);
+MqttPublisherStats mqtt_publisher_stats();
+
+#endif
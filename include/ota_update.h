@@ -0,0 +1,42 @@
+#ifndef OTA_UPDATE_H
+#define OTA_UPDATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Streaming firmware update into the inactive OTA slot. A gzip image
+// (recognised by its magic bytes) is inflated through a fixed 32 KB window
+// straight into flash; a plain image is written as it arrives. Neither is
+// ever held in RAM whole. The SHA-256 of the uncompressed image must match
+// the one passed to ota_update_begin(), otherwise the slot is abandoned and
+// the running firmware stays the boot image.
+
+struct OtaResult {
+    bool compressed;
+    uint32_t received;          // bytes uploaded
+    uint32_t written;           // image bytes written to flash
+    uint32_t elapsedMs;         // first byte to verified image
+    uint32_t minFreeHeap;       // lowest free heap seen during the update
+    const char* error;          // NULL on success, else a snake_case reason
+};
+
+// expectedSha256 is 64 hex digits. Returns the session id, or 0 with
+// result->error set when an update is already running, there is no OTA
+// slot, or memory is short.
+uint32_t ota_update_begin(const char* expectedSha256, OtaResult* result);
+bool ota_update_write(const uint8_t* data, size_t len);
+
+// Verifies the image and makes it the boot partition; result is filled in
+// either way
+bool ota_update_finish(OtaResult* result);
+
+// Abandons the slot if session id is still the running update (e.g. the
+// uploading client went away)
+void ota_update_abort(uint32_t id);
+bool ota_update_active();
+
+// Marks a freshly updated image valid once it has been up for
+// OTA_CONFIRM_MS; a reset before that boots the previous image again
+void ota_update_poll();
+
+#endif
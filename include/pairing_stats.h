@@ -0,0 +1,66 @@
+#ifndef PAIRING_STATS_H
+#define PAIRING_STATS_H
+
+#include <stdint.h>
+
+// Pairing timing and outcome, aggregated per WiFi/BLE coexistence policy so
+// policies can be compared on the same unit. Updated from the BLE callbacks.
+
+#define PAIRING_POLICY_COUNT 3
+
+struct PairingPolicyStats {
+    uint32_t attempts;
+    uint32_t successes;
+    uint32_t failures;          // auth failure or disconnect before completion
+    uint32_t totalMs;           // sum of connect -> auth complete, successes only
+    uint32_t minMs;
+    uint32_t maxMs;
+    uint32_t lastMs;
+};
+
+// Connect to first key distribution event, split by whether fast connection
+// parameters were requested for the attempt
+struct PairingLatencyStats {
+    uint32_t samples;
+    uint32_t totalMs;
+    uint32_t minMs;
+    uint32_t maxMs;
+    uint32_t lastMs;
+};
+
+// Successful pairings split at the phone's pairing request and the first key
+// distribution event, which every pairing flow reports (Just Works included):
+//   request   connect -> pairing request; 0 if the stack reported none
+//   security  pairing request -> first key: feature exchange, local P-256 key
+//             pair, public key exchange, DHKey (LE Secure Connections),
+//             confirm and DHKey check, encryption
+//   keys      first key -> authentication complete: key distribution
+// Re-encryption of a known bond distributes no keys and is not split.
+#define PAIRING_STAGE_COUNT 3
+
+enum PairingStage {
+    STAGE_REQUEST = 0,
+    STAGE_SECURITY,
+    STAGE_KEYS
+};
+
+struct PairingStageStats {
+    uint32_t samples;
+    uint32_t totalMs[PAIRING_STAGE_COUNT];
+    uint32_t maxMs[PAIRING_STAGE_COUNT];
+    uint32_t lastMs[PAIRING_STAGE_COUNT];
+};
+
+void pairing_stats_connect(uint8_t policy, bool fastConn);
+void pairing_stats_request();
+void pairing_stats_key();
+void pairing_stats_complete(bool success);
+void pairing_stats_disconnect();
+
+bool pairing_stats_active();
+PairingPolicyStats pairing_stats_get(uint8_t policy);
+PairingLatencyStats pairing_stats_key_latency(bool fastConn);
+PairingStageStats pairing_stats_stages();
+const char* pairing_stage_name(uint8_t stage);
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef RPA_BATCH_H
+#define RPA_BATCH_H
+
+/*
+ * Batch address resolution shared by POST /api/resolve and its host build
+ * (tools/bench/resolve_batch_bench.cpp): parse the addresses, resolve them
+ * against the bonded IRKs, and write the JSON results array.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "json_writer.h"
+#include "rpa_resolver.h"
+
+namespace rpa {
+
+static const int INVALID_ADDRESS = -3;
+static const size_t ADDRESS_STR_LEN = 17;   // AA:BB:CC:DD:EE:FF
+
+// Identity of the bond behind each IRK index
+struct Identity {
+    uint8_t addr[6];
+    uint8_t addrType;
+};
+
+// Parse AA:BB:CC:DD:EE:FF (either case) into MSB-first bytes
+inline bool parseAddress(const char* s, size_t len, uint8_t* addr) {
+    if (len != ADDRESS_STR_LEN) return false;
+    for (int i = 0; i < 6; i++) {
+        uint8_t v = 0;
+        for (int j = 0; j < 2; j++) {
+            char c = s[i * 3 + j];
+            v <<= 4;
+            if (c >= '0' && c <= '9') v |= (uint8_t)(c - '0');
+            else if (c >= 'a' && c <= 'f') v |= (uint8_t)(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') v |= (uint8_t)(c - 'A' + 10);
+            else return false;
+        }
+        if (i < 5 && s[i * 3 + 2] != ':') return false;
+        addr[i] = v;
+    }
+    return true;
+}
+
+inline void formatAddress(const uint8_t* addr, char* out) {
+    snprintf(out, ADDRESS_STR_LEN + 1, "%02X:%02X:%02X:%02X:%02X:%02X",
+             addr[0], addr[1], addr[2], addr[3], addr[4], addr[5]);
+}
+
+inline const char* resultName(int result) {
+    if (result >= 0) return "resolved";
+    switch (result) {
+        case NO_MATCH: return "no_match";
+        case NOT_RESOLVABLE: return "not_rpa";
+        default: return "invalid";
+    }
+}
+
+// Resolve addrs[i] into results[i]; entries already set to INVALID_ADDRESS
+// are skipped. Returns the number resolved to an IRK.
+template <typename R>
+size_t resolveBatch(R& resolver, const uint8_t (*addrs)[6], int* results, size_t n, uint32_t nowMs) {
+    size_t matched = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (results[i] == INVALID_ADDRESS) continue;
+        results[i] = resolver.resolve(addrs[i], nowMs);
+        if (results[i] >= 0) matched++;
+    }
+    return matched;
+}
+
+// One {"address","status","identity","identityType"} object per address
+template <typename Out>
+void writeResults(JsonWriter<Out>& json, const uint8_t (*addrs)[6], const int* results, size_t n,
+                  const Identity* identities) {
+    char str[ADDRESS_STR_LEN + 1];
+    json.beginArray();
+    for (size_t i = 0; i < n; i++) {
+        json.beginObject();
+        if (results[i] == INVALID_ADDRESS) {
+            json.key("address").null();
+        } else {
+            formatAddress(addrs[i], str);
+            json.field("address", str);
+        }
+        json.field("status", resultName(results[i]));
+        if (results[i] >= 0) {
+            const Identity& id = identities[results[i]];
+            formatAddress(id.addr, str);
+            json.field("identity", str);
+            json.field("identityType", id.addrType ? "random" : "public");
+        }
+        json.endObject();
+    }
+    json.endArray();
+}
+
+// Upper bound of one writeResults() element
+constexpr size_t resultJsonMax() {
+    return jsonsize::braces() + 1
+        + jsonsize::key("address") + jsonsize::plain(ADDRESS_STR_LEN)
+        + jsonsize::key("status") + jsonsize::plain(8)
+        + jsonsize::key("identity") + jsonsize::plain(ADDRESS_STR_LEN)
+        + jsonsize::key("identityType") + jsonsize::plain(6);
+}
+
+}  // namespace rpa
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef RPA_CACHE_H
+#define RPA_CACHE_H
+
+/*
+ * Cache of recently resolved RPAs.
+ *
+ * Phones rotate their RPA about every 15 minutes but advertise many times a
+ * second, so the same address is resolved over and over. The cache maps a
+ * 6-byte address to the IRK index it resolved to, or to a negative result,
+ * for ttlMs. Entries are open-addressed: an address may live in any of
+ * PROBE slots after its hash slot, and inserts take a free or expired slot
+ * there or evict the oldest. Nothing is allocated after construction.
+ *
+ * CachedResolver puts the cache in front of rpa::Resolver and rejects
+ * addresses that cannot be RPAs before touching either.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "rpa_resolver.h"
+
+namespace rpa {
+
+struct CacheStats {
+    uint32_t lookups;
+    uint32_t hits;
+    uint32_t misses;            // resolved with AES
+    uint32_t rejected;          // not an RPA, no lookup needed
+    uint32_t evictions;         // live entry replaced to make room
+};
+
+template <uint16_t Slots, uint8_t Probe = 8>
+class Cache {
+    static_assert((Slots & (Slots - 1)) == 0, "Slots must be a power of two");
+    static_assert(Probe > 0 && Probe <= Slots, "Probe must be 1..Slots");
+
+public:
+    explicit Cache(uint32_t ttlMs) : ttlMs_(ttlMs) { clear(); }
+
+    // Drop everything, e.g. when an IRK is added or removed
+    void clear() { memset(entries_, 0, sizeof(entries_)); }
+
+    bool lookup(const uint8_t* addr, uint32_t nowMs, int* result) const {
+        uint32_t pos = hash(addr);
+        for (uint8_t i = 0; i < Probe; i++) {
+            const Entry& e = entries_[(pos + i) & (Slots - 1)];
+            if (e.used && live(e, nowMs) && memcmp(e.addr, addr, 6) == 0) {
+                *result = e.result;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Returns true if a live entry for another address had to be evicted
+    bool insert(const uint8_t* addr, int result, uint32_t nowMs) {
+        uint32_t pos = hash(addr);
+        Entry* target = NULL;
+        Entry* oldest = NULL;
+        for (uint8_t i = 0; i < Probe; i++) {
+            Entry& e = entries_[(pos + i) & (Slots - 1)];
+            if (e.used && memcmp(e.addr, addr, 6) == 0) {
+                target = &e;
+                break;
+            }
+            if (!target && (!e.used || !live(e, nowMs))) {
+                target = &e;
+            }
+            if (!oldest || (int32_t)(e.storedMs - oldest->storedMs) < 0) {
+                oldest = &e;
+            }
+        }
+
+        bool evicted = false;
+        if (!target) {
+            target = oldest;
+            evicted = true;
+        }
+        memcpy(target->addr, addr, 6);
+        target->used = 1;
+        target->result = (int16_t)result;
+        target->storedMs = nowMs;
+        return evicted;
+    }
+
+    static constexpr uint16_t slots() { return Slots; }
+
+private:
+    struct Entry {
+        uint8_t addr[6];
+        uint8_t used;
+        int16_t result;
+        uint32_t storedMs;
+    };
+
+    bool live(const Entry& e, uint32_t nowMs) const {
+        return nowMs - e.storedMs < ttlMs_;
+    }
+
+    // Mix all six bytes; the hash half of an RPA alone is already uniform
+    // but negative entries also hold non-random addresses
+    static uint32_t hash(const uint8_t* addr) {
+        uint32_t lo = (uint32_t)addr[3] | ((uint32_t)addr[4] << 8) | ((uint32_t)addr[5] << 16);
+        uint32_t hi = (uint32_t)addr[0] | ((uint32_t)addr[1] << 8) | ((uint32_t)addr[2] << 16);
+        return ((lo ^ (hi * 0x9E3779B1u)) * 0x85EBCA6Bu) >> 16;
+    }
+
+    Entry entries_[Slots];
+    uint32_t ttlMs_;
+};
+
+template <typename Cipher, uint16_t MaxKeys, uint16_t Slots, uint8_t Probe = 8>
+class CachedResolver {
+public:
+    explicit CachedResolver(uint32_t ttlMs) : cache_(ttlMs) { resetStats(); }
+
+    // Changing the IRK set invalidates every cached result
+    void clear() {
+        resolver_.clear();
+        cache_.clear();
+    }
+
+    bool add(const uint8_t* irk) {
+        cache_.clear();
+        return resolver_.add(irk);
+    }
+
+    int resolve(const uint8_t* addr, uint32_t nowMs) {
+        stats_.lookups++;
+        if (!isResolvable(addr)) {
+            stats_.rejected++;
+            return NOT_RESOLVABLE;
+        }
+        int result;
+        if (cache_.lookup(addr, nowMs, &result)) {
+            stats_.hits++;
+            return result;
+        }
+        stats_.misses++;
+        result = resolver_.resolve(addr);
+        if (cache_.insert(addr, result, nowMs)) stats_.evictions++;
+        return result;
+    }
+
+    uint16_t size() const { return resolver_.size(); }
+    const CacheStats& stats() const { return stats_; }
+    void resetStats() { memset(&stats_, 0, sizeof(stats_)); }
+
+private:
+    Resolver<Cipher, MaxKeys> resolver_;
+    Cache<Slots, Probe> cache_;
+    CacheStats stats_;
+};
+
+}  // namespace rpa
+
+#endif
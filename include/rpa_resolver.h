@@ -0,0 +1,87 @@
+#ifndef RPA_RESOLVER_H
+#define RPA_RESOLVER_H
+
+/*
+ * Resolvable private address (RPA) resolution against a set of IRKs.
+ *
+ * An RPA is prand (3 bytes, top two bits 01) followed by hash (3 bytes),
+ * where hash = ah(IRK, prand) = AES-128(IRK, 0^104 || prand) mod 2^24
+ * (Core spec Vol 3 Part H 2.2.2).
+ *
+ * Byte order follows Bluedroid: addresses MSB first as in esp_bd_addr_t
+ * (addr[0..2] = prand, addr[3..5] = hash), IRKs LSB first as stored in
+ * pid_key.irk. The AES key schedule of every IRK is expanded once when the
+ * IRK is added and reused for every address.
+ *
+ * Cipher provides setKey(const uint8_t[16]) and
+ * encrypt(const uint8_t in[16], uint8_t out[16]) with MSB-first key and
+ * blocks; aes128::Cipher is the portable implementation.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace rpa {
+
+enum : int {
+    NO_MATCH = -1,              // resolvable, but no IRK matches
+    NOT_RESOLVABLE = -2,        // public, static or non-resolvable private
+};
+
+// Random private resolvable: top two bits of the most significant byte are 01
+inline bool isResolvable(const uint8_t* addr) {
+    return (addr[0] & 0xC0) == 0x40;
+}
+
+// ah() with a prepared cipher; hash is written MSB first
+template <typename Cipher>
+inline void ah(const Cipher& cipher, const uint8_t* prand, uint8_t* hash) {
+    uint8_t block[16] = {0};
+    block[13] = prand[0];
+    block[14] = prand[1];
+    block[15] = prand[2];
+    uint8_t out[16];
+    cipher.encrypt(block, out);
+    hash[0] = out[13];
+    hash[1] = out[14];
+    hash[2] = out[15];
+}
+
+template <typename Cipher, uint16_t MaxKeys>
+class Resolver {
+public:
+    Resolver() : count_(0) {}
+
+    void clear() { count_ = 0; }
+
+    // irk is LSB first (pid_key.irk); returns false when full
+    bool add(const uint8_t* irk) {
+        if (count_ >= MaxKeys) return false;
+        uint8_t key[16];
+        for (int i = 0; i < 16; i++) key[i] = irk[15 - i];
+        ciphers_[count_++].setKey(key);
+        return true;
+    }
+
+    // Index of the IRK that generated addr, NO_MATCH or NOT_RESOLVABLE
+    int resolve(const uint8_t* addr) const {
+        if (!isResolvable(addr)) return NOT_RESOLVABLE;
+        uint8_t hash[3];
+        for (uint16_t i = 0; i < count_; i++) {
+            ah(ciphers_[i], addr, hash);
+            if (memcmp(hash, addr + 3, 3) == 0) return i;
+        }
+        return NO_MATCH;
+    }
+
+    uint16_t size() const { return count_; }
+
+private:
+    Cipher ciphers_[MaxKeys];
+    uint16_t count_;
+};
+
+}  // namespace rpa
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef RPA_SERVICE_H
+#define RPA_SERVICE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "rpa_batch.h"
+
+// On-device RPA resolution against every bonded IRK. The IRK set is loaded
+// from the bond list on first use and reloaded after rpa_service_invalidate()
+// or when the bond count changes. AES runs through mbedTLS, which uses the
+// hardware accelerator, unless RESOLVE_HW_AES is 0.
+
+struct RpaBatchStats {
+    uint16_t irks;              // bonded IRKs resolved against
+    size_t matched;
+    uint32_t elapsedUs;         // time spent resolving, excluding parsing
+    bool hardwareAes;
+};
+
+void rpa_service_begin();
+
+// Called whenever bonds are added or removed
+void rpa_service_invalidate();
+
+// Resolve a batch (see rpa::resolveBatch); results[i] = INVALID_ADDRESS
+// marks entries to skip. identities receives a copy of the bond identities
+// indexed by result and must hold RESOLVE_MAX_IRKS entries.
+RpaBatchStats rpa_service_resolve(const uint8_t (*addrs)[6], int* results, size_t n, rpa::Identity* identities);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef SC_ECC_H
+#define SC_ECC_H
+
+#include <stdint.h>
+
+// P-256 cost of an LE Secure Connections pairing on this chip. Bluedroid
+// generates the local key pair and the DHKey itself on every pairing, on
+// the BT host task; this measures the same two point multiplications once,
+// in a background task after boot, through mbedTLS with the MPI accelerator,
+// and validates the results.
+
+struct ScEccPathStats {
+    bool valid;                 // key pair on the curve, both DHKeys agree
+    uint32_t keyPairUs;
+    uint32_t dhKeyUs;
+};
+
+struct ScEccStats {
+    bool done;
+    ScEccPathStats mbedtls;
+};
+
+// Starts the background measurement when SC_ECC_PROBE and SC_ECC_HW are set
+void sc_ecc_begin();
+ScEccStats sc_ecc_stats();
+
+#endif
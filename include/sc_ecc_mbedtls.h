@@ -0,0 +1,62 @@
+#ifndef SC_ECC_MBEDTLS_H
+#define SC_ECC_MBEDTLS_H
+
+/*
+ * The P-256 calls the SC ECC probe makes, through mbedTLS (2.x API, as in
+ * ESP-IDF 4.4).
+ *
+ * Generates a local key pair, validates it, and computes the DHKey against
+ * a second, untimed key pair, checking that both sides agree. Random bytes
+ * and the microsecond clock are passed in, so the firmware (esp_fill_random,
+ * micros) and tools/bench/sc_ecc_check (host mbedTLS) run the same code.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "mbedtls/ecdh.h"
+#include "mbedtls/ecp.h"
+#include "sc_ecc.h"
+
+namespace scecc {
+
+typedef int (*RandomFn)(void* ctx, unsigned char* buf, size_t len);
+typedef uint32_t (*ClockUsFn)();
+
+inline void measure(ScEccPathStats& s, RandomFn rng, void* rngCtx, ClockUsFn clockUs) {
+    mbedtls_ecp_group grp;
+    mbedtls_mpi da, db, za, zb;
+    mbedtls_ecp_point qa, qb;
+    mbedtls_ecp_group_init(&grp);
+    mbedtls_mpi_init(&da);
+    mbedtls_mpi_init(&db);
+    mbedtls_mpi_init(&za);
+    mbedtls_mpi_init(&zb);
+    mbedtls_ecp_point_init(&qa);
+    mbedtls_ecp_point_init(&qb);
+
+    bool ok = mbedtls_ecp_group_load(&grp, MBEDTLS_ECP_DP_SECP256R1) == 0;
+
+    uint32_t t = clockUs();
+    ok = ok && mbedtls_ecdh_gen_public(&grp, &da, &qa, rng, rngCtx) == 0;
+    s.keyPairUs = clockUs() - t;
+    ok = ok && mbedtls_ecp_check_pubkey(&grp, &qa) == 0
+         && mbedtls_ecdh_gen_public(&grp, &db, &qb, rng, rngCtx) == 0;
+
+    t = clockUs();
+    ok = ok && mbedtls_ecdh_compute_shared(&grp, &za, &qb, &da, rng, rngCtx) == 0;
+    s.dhKeyUs = clockUs() - t;
+    s.valid = ok && mbedtls_ecdh_compute_shared(&grp, &zb, &qa, &db, rng, rngCtx) == 0
+              && mbedtls_mpi_cmp_mpi(&za, &zb) == 0;
+
+    mbedtls_ecp_point_free(&qb);
+    mbedtls_ecp_point_free(&qa);
+    mbedtls_mpi_free(&zb);
+    mbedtls_mpi_free(&za);
+    mbedtls_mpi_free(&db);
+    mbedtls_mpi_free(&da);
+    mbedtls_ecp_group_free(&grp);
+}
+
+}  // namespace scecc
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef SERIAL_LINK_H
+#define SERIAL_LINK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "irk_frame.h"
+
+// Framed binary IRK link on the serial port (format in irk_frame.h).
+// Every function is a no-op unless SERIAL_PROTOCOL_ENABLED is set.
+
+typedef void (*serial_link_command_cb_t)(uint8_t type, const uint8_t* payload, size_t len);
+
+void serial_link_begin(serial_link_command_cb_t onCommand);
+void serial_link_poll();
+
+void serial_link_send(uint8_t type, const uint8_t* payload, size_t len);
+void serial_link_send_irk(const uint8_t* addr, uint8_t addrType, const uint8_t* irk);
+void serial_link_send_bond_entry(const uint8_t* addr, uint8_t addrType);
+void serial_link_send_bond_removed(const uint8_t* addr);
+void serial_link_send_list_end(uint8_t count);
+void serial_link_send_status(uint8_t bonds, bool irkRetrieved);
+void serial_link_send_ack(uint8_t command, uint8_t status);
+
+#endif
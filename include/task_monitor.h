@@ -0,0 +1,54 @@
+#ifndef TASK_MONITOR_H
+#define TASK_MONITOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Per-task stack, priority and core, and CPU share over a sliding window
+// from the FreeRTOS run-time counters, sampled from loop(), plus a time
+// budget check on every BT callback.
+
+#define TASK_NAME_LEN 16
+
+struct TaskInfo {
+    char name[TASK_NAME_LEN];
+    uint8_t priority;
+    int8_t core;                // -1 when not pinned or not reported
+    uint32_t stackFree;         // high-water mark, bytes never used
+    uint16_t cpuPermille;       // of one core, over the window; 0 without run-time counters
+};
+
+struct TaskMonitorStats {
+    bool runtimeStats;          // false: no run-time counters, so no CPU shares
+    uint32_t samples;
+    uint32_t windowMs;          // span actually covered by the current figures
+    uint32_t lastSampleUs;      // cost of the last sample
+    uint32_t maxSampleUs;
+    uint32_t overheadPpm;       // time spent sampling / time since the first sample
+    uint32_t truncated;         // samples skipped, more than TASK_MONITOR_MAX_TASKS tasks
+};
+
+struct BtCallbackStats {
+    uint32_t calls;
+    uint32_t overruns;          // callbacks longer than BT_CALLBACK_BUDGET_US
+    uint32_t maxUs;
+    uint8_t maxSource;          // TraceSource / event id of the slowest callback
+    uint8_t maxEvent;
+    uint32_t lastOverrunUs;
+    uint8_t lastOverrunSource;
+    uint8_t lastOverrunEvent;
+    uint32_t lastOverrunMs;     // millis() of the last overrun
+};
+
+void task_monitor_begin();
+void task_monitor_poll();       // samples every TASK_MONITOR_SAMPLE_MS; no-op without HTTP_DEBUG_ENDPOINTS
+
+// Tasks as of the last sample; returns the number written
+size_t task_monitor_tasks(TaskInfo* out, size_t max);
+TaskMonitorStats task_monitor_stats();
+
+// Called after each GAP/GATTS callback with its duration
+void task_monitor_bt_callback(uint8_t source, uint8_t event, uint32_t elapsedUs);
+BtCallbackStats task_monitor_bt_stats();
+
+#endif
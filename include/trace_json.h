@@ -0,0 +1,183 @@
+#ifndef TRACE_JSON_H
+#define TRACE_JSON_H
+
+/*
+ * Chrome Trace Event JSON for a snapshot of the BLE event trace, produced in
+ * chunks of any size so it can feed a chunked HTTP response without
+ * building the document in memory. Open the output in Perfetto or
+ * chrome://tracing.
+ *
+ * Each event becomes an instant event; connect -> auth complete and
+ * connect -> disconnect are also emitted as "pairing" and "connection"
+ * slices. No Arduino dependencies.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "json_writer.h"
+
+struct TraceEvent {
+    uint32_t us;                // esp_timer time, wraps after ~71 minutes
+    uint8_t source;             // TraceSource
+    uint8_t event;              // esp_gap_ble_cb_event_t / esp_gatts_cb_event_t
+    uint16_t conn;              // connection id, or TRACE_NO_CONN
+    uint16_t status;            // event status / reason, 0 if none
+    uint16_t reserved;
+};
+
+enum TraceSource : uint8_t {
+    TRACE_GAP = 0,
+    TRACE_GATTS = 1,
+};
+
+static const uint16_t TRACE_NO_CONN = 0xFFFF;
+
+// Which events open and close the derived slices
+struct TraceSpanEvents {
+    uint8_t connect;            // GATTS
+    uint8_t disconnect;         // GATTS
+    uint8_t authComplete;       // GAP
+};
+
+typedef const char* (*trace_name_fn_t)(const TraceEvent& ev);
+
+class TraceJsonStream {
+public:
+    TraceJsonStream(const TraceEvent* events, size_t count, trace_name_fn_t name, const TraceSpanEvents& spans)
+        : events_(events), count_(count), name_(name), spans_(spans), next_(0), phase_(HEADER),
+          pendingLen_(0), pendingOff_(0), first_(true), base_(count ? events[0].us : 0),
+          connectTs_(0), connected_(false), pairing_(false), spanQueued_(false) {}
+
+    // Write up to maxLen bytes; returns 0 once the document is complete
+    size_t fill(uint8_t* buf, size_t maxLen) {
+        size_t written = 0;
+        while (written < maxLen) {
+            if (pendingOff_ == pendingLen_ && !render()) break;
+            size_t n = pendingLen_ - pendingOff_;
+            if (n > maxLen - written) n = maxLen - written;
+            memcpy(buf + written, pending_ + pendingOff_, n);
+            pendingOff_ += n;
+            written += n;
+        }
+        return written;
+    }
+
+private:
+    enum Phase { HEADER, EVENTS, FOOTER, DONE };
+
+    // Render the next piece into pending_; false when nothing is left
+    bool render() {
+        BufferOut out(pending_, sizeof(pending_));
+        switch (phase_) {
+            case HEADER: {
+                const char* h = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+                out.write((const uint8_t*)h, strlen(h));
+                phase_ = EVENTS;
+                break;
+            }
+            case EVENTS:
+                if (spanQueued_) {
+                    renderSpan(out);
+                } else if (next_ < count_) {
+                    renderEvent(out, events_[next_++]);
+                } else {
+                    phase_ = FOOTER;
+                    return render();
+                }
+                break;
+            case FOOTER:
+                out.write((const uint8_t*)"]}", 2);
+                phase_ = DONE;
+                break;
+            case DONE:
+                return false;
+        }
+        pendingLen_ = out.length();
+        pendingOff_ = 0;
+        return true;
+    }
+
+    uint32_t ts(const TraceEvent& ev) const {
+        return ev.us - base_;   // relative to the oldest event, wrap-safe
+    }
+
+    void comma(BufferOut& out) {
+        if (!first_) out.write((const uint8_t*)",", 1);
+        first_ = false;
+    }
+
+    void renderEvent(BufferOut& out, const TraceEvent& ev) {
+        comma(out);
+        JsonWriter<BufferOut> json(out);
+        json.beginObject();
+        json.field("name", name_(ev));
+        json.field("cat", ev.source == TRACE_GAP ? "gap" : "gatts");
+        json.field("ph", "i");
+        json.field("s", "g");
+        json.field("ts", ts(ev));
+        json.field("pid", 1);
+        json.field("tid", ev.source == TRACE_GAP ? 1 : 2);
+        json.key("args").beginObject();
+        if (ev.conn != TRACE_NO_CONN) json.field("conn", ev.conn);
+        json.field("status", ev.status);
+        json.endObject();
+        json.endObject();
+
+        // Queue a slice when this event closes one
+        if (ev.source == TRACE_GATTS && ev.event == spans_.connect) {
+            connectTs_ = ts(ev);
+            connected_ = true;
+            pairing_ = true;
+        } else if (ev.source == TRACE_GAP && ev.event == spans_.authComplete && pairing_) {
+            queueSpan("pairing", ts(ev));
+            pairing_ = false;
+        } else if (ev.source == TRACE_GATTS && ev.event == spans_.disconnect && connected_) {
+            queueSpan("connection", ts(ev));
+            connected_ = false;
+            pairing_ = false;
+        }
+    }
+
+    void queueSpan(const char* name, uint32_t endTs) {
+        spanName_ = name;
+        spanEnd_ = endTs;
+        spanQueued_ = true;
+    }
+
+    void renderSpan(BufferOut& out) {
+        spanQueued_ = false;
+        comma(out);
+        JsonWriter<BufferOut> json(out);
+        json.beginObject();
+        json.field("name", spanName_);
+        json.field("cat", "link");
+        json.field("ph", "X");
+        json.field("ts", connectTs_);
+        json.field("dur", spanEnd_ - connectTs_);
+        json.field("pid", 1);
+        json.field("tid", 3);
+        json.endObject();
+    }
+
+    const TraceEvent* events_;
+    size_t count_;
+    trace_name_fn_t name_;
+    TraceSpanEvents spans_;
+    size_t next_;
+    Phase phase_;
+    char pending_[256];
+    size_t pendingLen_;
+    size_t pendingOff_;
+    bool first_;
+    uint32_t base_;
+    uint32_t connectTs_;
+    bool connected_;
+    bool pairing_;
+    bool spanQueued_;
+    const char* spanName_;
+    uint32_t spanEnd_;
+};
+
+#endif
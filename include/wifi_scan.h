@@ -0,0 +1,31 @@
+#ifndef WIFI_SCAN_H
+#define WIFI_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Cached asynchronous WiFi scan for the configuration page. Scans run in the
+// background (never blocking the caller), only when the cache is older than
+// WIFI_SCAN_TTL_MS and no BLE pairing is in progress. Results are
+// de-duplicated by SSID (strongest signal kept) and sorted by signal strength.
+// Not thread-safe: call only from the web server (AsyncTCP) task.
+
+struct WiFiScanNetwork {
+    char ssid[33];
+    int8_t rssi;
+    uint8_t channel;
+    bool secure;
+};
+
+struct WiFiScanSnapshot {
+    const WiFiScanNetwork* networks;
+    size_t count;
+    bool valid;             // at least one scan has completed
+    bool scanning;
+    uint32_t ageMs;
+};
+
+// Harvest finished scan results and start a new scan if the cache is stale
+WiFiScanSnapshot wifi_scan_refresh();
+
+#endif
@@ -47,7 +47,10 @@ def load_dotenv():
 
                 # Set as build flag
                 # For string values, add quotes
-                if key in ['WIFI_SSID', 'WIFI_PASSWORD', 'AP_SSID', 'AP_PASSWORD', 'BLE_DEVICE_NAME']:
+                if key in ['WIFI_SSID', 'WIFI_PASSWORD', 'AP_SSID', 'AP_PASSWORD', 'BLE_DEVICE_NAME',
+                           'MQTT_HOST', 'MQTT_USER', 'MQTT_PASSWORD', 'MQTT_TOPIC_PREFIX',
+                           'MQTT_DISCOVERY_PREFIX', 'LOG_SHIP_HOST', 'MDNS_HOSTNAME',
+                           'OTA_TOKEN']:
                     env.Append(CPPDEFINES=[(key, f'\\"{value}\\"')])
                 # For numeric/boolean values, no quotes
                 else:
@@ -57,6 +60,10 @@ def load_dotenv():
                     elif value.lower() == 'false':
                         value = '0'
                     env.Append(CPPDEFINES=[(key, value)])
+                    # The log shipper hooks esp_log, which ESP_LOGx only
+                    # reaches with USE_ESP_IDF_LOG
+                    if key == 'LOG_SHIP_ENABLED' and value == '1':
+                        env.Append(CPPDEFINES=['USE_ESP_IDF_LOG'])
 
                 print(f"Loaded from .env: {key}")
 
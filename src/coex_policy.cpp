@@ -0,0 +1,71 @@
+/*
+ * WiFi/BLE coexistence policy control
+ */
+
+#include <Arduino.h>
+#include "config.h"
+#include "coex_policy.h"
+
+#if !HEADLESS_MODE
+#include "esp_coexist.h"
+#endif
+
+#define COEX_TAG "COEX"
+
+static uint8_t pairingPolicy = COEX_POLICY_PAIRING;
+static uint8_t idlePolicy = COEX_POLICY_IDLE;
+
+static void apply(uint8_t policy) {
+#if !HEADLESS_MODE
+    esp_err_t err = esp_coex_preference_set((esp_coex_prefer_t)policy);
+    if (err != ESP_OK) {
+        ESP_LOGW(COEX_TAG, "Setting coexistence preference %s failed: %d", coex_policy_name(policy), err);
+    } else {
+        ESP_LOGD(COEX_TAG, "Coexistence preference: %s", coex_policy_name(policy));
+    }
+#endif
+}
+
+void coex_policy_begin() {
+    apply(idlePolicy);
+}
+
+void coex_policy_pairing_started() {
+    apply(pairingPolicy);
+}
+
+void coex_policy_pairing_finished() {
+    apply(idlePolicy);
+}
+
+bool coex_policy_set(uint8_t pairing, uint8_t idle) {
+    if (pairing > COEX_PREFER_BALANCE || idle > COEX_PREFER_BALANCE) return false;
+    pairingPolicy = pairing;
+    idlePolicy = idle;
+    apply(idlePolicy);
+    return true;
+}
+
+uint8_t coex_policy_pairing() {
+    return pairingPolicy;
+}
+
+uint8_t coex_policy_idle() {
+    return idlePolicy;
+}
+
+const char* coex_policy_name(uint8_t policy) {
+    switch (policy) {
+        case COEX_PREFER_WIFI: return "wifi";
+        case COEX_PREFER_BT: return "bt";
+        case COEX_PREFER_BALANCE: return "balance";
+        default: return "unknown";
+    }
+}
+
+int coex_policy_parse(const char* name) {
+    for (uint8_t p = 0; p <= COEX_PREFER_BALANCE; p++) {
+        if (strcmp(name, coex_policy_name(p)) == 0) return p;
+    }
+    return -1;
+}
@@ -0,0 +1,61 @@
+/*
+ * Connection-parameter policy during pairing
+ */
+
+#include <Arduino.h>
+#include "esp_gatts_api.h"
+#include "config.h"
+#include "conn_params.h"
+
+#define CONN_TAG "CONN"
+
+static bool fastEnabled = CONN_FAST_PAIRING;
+
+static void request(const uint8_t* bda, uint16_t minInt, uint16_t maxInt) {
+    esp_ble_conn_update_params_t params = {};
+    memcpy(params.bda, bda, sizeof(esp_bd_addr_t));
+    params.min_int = minInt;
+    params.max_int = maxInt;
+    params.latency = 0;
+    params.timeout = CONN_SUPERVISION_TIMEOUT;
+    esp_err_t err = esp_ble_gap_update_conn_params(&params);
+    if (err != ESP_OK) {
+        ESP_LOGW(CONN_TAG, "Connection parameter update request failed: %d", err);
+    }
+}
+
+void conn_params_on_connect(const esp_ble_gatts_cb_param_t::gatts_connect_evt_param& connect) {
+    // Intervals are in 1.25 ms units, the supervision timeout in 10 ms units
+    Serial.printf("Connection parameters: interval %.2f ms, latency %u, timeout %u ms\n",
+                  connect.conn_params.interval * 1.25f, connect.conn_params.latency,
+                  connect.conn_params.timeout * 10);
+    if (fastEnabled) {
+        request(connect.remote_bda, CONN_FAST_MIN_INTERVAL, CONN_FAST_MAX_INTERVAL);
+    }
+}
+
+void conn_params_on_paired(esp_bd_addr_t bda) {
+    if (!fastEnabled) return;
+#if CONN_DISCONNECT_AFTER_PAIRING
+    esp_ble_gap_disconnect(bda);
+#else
+    request(bda, CONN_RELAXED_MIN_INTERVAL, CONN_RELAXED_MAX_INTERVAL);
+#endif
+}
+
+void conn_params_on_update(const esp_ble_gap_cb_param_t::ble_update_conn_params_evt_param& update) {
+    if (update.status != ESP_BT_STATUS_SUCCESS) {
+        Serial.printf("Connection parameter update rejected, status %d\n", update.status);
+        return;
+    }
+    Serial.printf("Connection parameters: interval %.2f ms, latency %u, timeout %u ms\n",
+                  update.conn_int * 1.25f, update.latency, update.timeout * 10);
+}
+
+void conn_params_set_fast(bool enabled) {
+    fastEnabled = enabled;
+}
+
+bool conn_params_fast() {
+    return fastEnabled;
+}
@@ -0,0 +1,81 @@
+/*
+ * Deferred job scheduler
+ */
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "config.h"
+#include "deferred_jobs.h"
+
+#define DEFERRED_TAG "DEFERRED"
+
+struct DeferredJob {
+    deferred_job_fn_t fn;
+    void* arg;
+    uint32_t due;       // millis()
+    uint32_t seq;       // posting order, breaks ties between equal due times
+};
+
+static QueueHandle_t jobQueue = NULL;
+static volatile uint32_t nextSeq = 0;
+
+static void schedulerTask(void* param) {
+    DeferredJob pending[DEFERRED_MAX_JOBS];
+    size_t count = 0;
+
+    for (;;) {
+        // Sleep until the earliest job is due or a new one arrives
+        TickType_t wait = portMAX_DELAY;
+        if (count > 0) {
+            int32_t ms = (int32_t)(pending[0].due - millis());
+            wait = ms > 0 ? pdMS_TO_TICKS(ms) : 0;
+        }
+
+        DeferredJob job;
+        if (count == DEFERRED_MAX_JOBS) {
+            // Table full: new jobs wait in the queue, and deferred_post fails
+            // once that fills too. No job ever runs before its due time.
+            vTaskDelay(wait);
+        } else if (xQueueReceive(jobQueue, &job, wait) == pdTRUE) {
+            // Keep the table ordered by due time, then posting order
+            size_t pos = count;
+            while (pos > 0 && ((int32_t)(pending[pos - 1].due - job.due) > 0 ||
+                               (pending[pos - 1].due == job.due && pending[pos - 1].seq > job.seq))) {
+                pending[pos] = pending[pos - 1];
+                pos--;
+            }
+            pending[pos] = job;
+            count++;
+        }
+
+        while (count > 0 && (int32_t)(millis() - pending[0].due) >= 0) {
+            DeferredJob due = pending[0];
+            count--;
+            memmove(&pending[0], &pending[1], count * sizeof(DeferredJob));
+            due.fn(due.arg);
+        }
+    }
+}
+
+void deferred_jobs_begin() {
+    jobQueue = xQueueCreate(DEFERRED_MAX_JOBS, sizeof(DeferredJob));
+    xTaskCreateUniversal(schedulerTask, "deferred", 4096, NULL, TASK_PRIO_DEFERRED, NULL, TASK_CORE_DEFERRED);
+}
+
+bool deferred_post(deferred_job_fn_t fn, void* arg, uint32_t delayMs) {
+    if (!jobQueue) return false;
+
+    DeferredJob job;
+    job.fn = fn;
+    job.arg = arg;
+    job.due = millis() + delayMs;
+    job.seq = nextSeq++;
+
+    if (xQueueSend(jobQueue, &job, 0) != pdTRUE) {
+        ESP_LOGE(DEFERRED_TAG, "Job queue full");
+        return false;
+    }
+    return true;
+}
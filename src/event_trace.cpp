@@ -0,0 +1,168 @@
+/*
+ * GAP/GATTS event trace ring
+ */
+
+#include <Arduino.h>
+#include "esp_timer.h"
+#include "config.h"
+#include "event_trace.h"
+
+static_assert((TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) == 0, "TRACE_RING_SIZE must be a power of two");
+
+#if TRACE_ENABLED
+static TraceEvent ring[TRACE_RING_SIZE];
+#endif
+static volatile uint32_t head = 0;      // total events written
+
+// Both callbacks run on the Bluedroid task, so there is a single writer.
+// The slot is filled before head is published for readers.
+static inline void record(uint8_t source, uint8_t event, uint16_t conn, uint16_t status) {
+#if TRACE_ENABLED
+    uint32_t h = head;
+    TraceEvent& ev = ring[h & (TRACE_RING_SIZE - 1)];
+    ev.us = (uint32_t)esp_timer_get_time();
+    ev.source = source;
+    ev.event = event;
+    ev.conn = conn;
+    ev.status = status;
+    __atomic_store_n(&head, h + 1, __ATOMIC_RELEASE);
+#endif
+}
+
+void event_trace_gap(esp_gap_ble_cb_event_t event, const esp_ble_gap_cb_param_t* param) {
+    uint16_t status = 0;
+    switch (event) {
+        case ESP_GAP_BLE_ADV_DATA_SET_COMPLETE_EVT:
+            status = param->adv_data_cmpl.status;
+            break;
+        case ESP_GAP_BLE_SCAN_RSP_DATA_SET_COMPLETE_EVT:
+            status = param->scan_rsp_data_cmpl.status;
+            break;
+        case ESP_GAP_BLE_ADV_START_COMPLETE_EVT:
+            status = param->adv_start_cmpl.status;
+            break;
+        case ESP_GAP_BLE_AUTH_CMPL_EVT:
+            status = param->ble_security.auth_cmpl.success ? 0 : param->ble_security.auth_cmpl.fail_reason;
+            break;
+        case ESP_GAP_BLE_KEY_EVT:
+            status = param->ble_security.ble_key.key_type;
+            break;
+        case ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT:
+            status = param->update_conn_params.status;
+            break;
+        case ESP_GAP_BLE_SET_LOCAL_PRIVACY_COMPLETE_EVT:
+            status = param->local_privacy_cmpl.status;
+            break;
+        default:
+            break;
+    }
+    record(TRACE_GAP, (uint8_t)event, TRACE_NO_CONN, status);
+}
+
+void event_trace_gatts(esp_gatts_cb_event_t event, const esp_ble_gatts_cb_param_t* param) {
+    uint16_t conn = TRACE_NO_CONN;
+    uint16_t status = 0;
+    switch (event) {
+        case ESP_GATTS_REG_EVT:
+            status = param->reg.status;
+            break;
+        case ESP_GATTS_CONNECT_EVT:
+            conn = param->connect.conn_id;
+            break;
+        case ESP_GATTS_DISCONNECT_EVT:
+            conn = param->disconnect.conn_id;
+            status = param->disconnect.reason;
+            break;
+        case ESP_GATTS_READ_EVT:
+            conn = param->read.conn_id;
+            status = param->read.handle;
+            break;
+        case ESP_GATTS_WRITE_EVT:
+            conn = param->write.conn_id;
+            status = param->write.handle;
+            break;
+        case ESP_GATTS_MTU_EVT:
+            conn = param->mtu.conn_id;
+            status = param->mtu.mtu;
+            break;
+        case ESP_GATTS_CREAT_ATTR_TAB_EVT:
+            status = param->add_attr_tab.status;
+            break;
+        case ESP_GATTS_START_EVT:
+            status = param->start.status;
+            break;
+        default:
+            break;
+    }
+    record(TRACE_GATTS, (uint8_t)event, conn, status);
+}
+
+size_t event_trace_snapshot(TraceEvent* out, size_t max) {
+#if TRACE_ENABLED
+    uint32_t end = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+    uint32_t start = end > TRACE_RING_SIZE ? end - TRACE_RING_SIZE : 0;
+    if (end - start > max) start = end - max;
+
+    for (uint32_t i = start; i < end; i++) {
+        out[i - start] = ring[i & (TRACE_RING_SIZE - 1)];
+    }
+
+    // Drop whatever the writer lapped while we were copying
+    uint32_t now = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+    uint32_t firstValid = now > TRACE_RING_SIZE ? now - TRACE_RING_SIZE : 0;
+    if (firstValid > start) {
+        uint32_t skip = firstValid - start;
+        if (skip >= end - start) return 0;
+        memmove(out, out + skip, (end - start - skip) * sizeof(TraceEvent));
+        return end - start - skip;
+    }
+    return end - start;
+#else
+    return 0;
+#endif
+}
+
+uint32_t event_trace_total() {
+    return head;
+}
+
+const char* event_trace_name(const TraceEvent& ev) {
+    if (ev.source == TRACE_GAP) {
+        switch (ev.event) {
+            case ESP_GAP_BLE_ADV_DATA_SET_COMPLETE_EVT: return "adv_data_set";
+            case ESP_GAP_BLE_SCAN_RSP_DATA_SET_COMPLETE_EVT: return "scan_rsp_data_set";
+            case ESP_GAP_BLE_ADV_START_COMPLETE_EVT: return "adv_start";
+            case ESP_GAP_BLE_PASSKEY_NOTIF_EVT: return "passkey_notif";
+            case ESP_GAP_BLE_NC_REQ_EVT: return "nc_req";
+            case ESP_GAP_BLE_SEC_REQ_EVT: return "sec_req";
+            case ESP_GAP_BLE_AUTH_CMPL_EVT: return "auth_cmpl";
+            case ESP_GAP_BLE_KEY_EVT: return "key";
+            case ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT: return "update_conn_params";
+            case ESP_GAP_BLE_SET_LOCAL_PRIVACY_COMPLETE_EVT: return "set_local_privacy";
+            case ESP_GAP_BLE_ADV_STOP_COMPLETE_EVT: return "adv_stop";
+            case ESP_GAP_BLE_SET_PKT_LENGTH_COMPLETE_EVT: return "set_pkt_length";
+            default: return "gap_event";
+        }
+    }
+    switch (ev.event) {
+        case ESP_GATTS_REG_EVT: return "reg";
+        case ESP_GATTS_READ_EVT: return "read";
+        case ESP_GATTS_WRITE_EVT: return "write";
+        case ESP_GATTS_MTU_EVT: return "mtu";
+        case ESP_GATTS_CONF_EVT: return "conf";
+        case ESP_GATTS_START_EVT: return "start";
+        case ESP_GATTS_CONNECT_EVT: return "connect";
+        case ESP_GATTS_DISCONNECT_EVT: return "disconnect";
+        case ESP_GATTS_CREAT_ATTR_TAB_EVT: return "creat_attr_tab";
+        case ESP_GATTS_RESPONSE_EVT: return "response";
+        default: return "gatts_event";
+    }
+}
+
+TraceSpanEvents event_trace_spans() {
+    TraceSpanEvents spans;
+    spans.connect = ESP_GATTS_CONNECT_EVT;
+    spans.disconnect = ESP_GATTS_DISCONNECT_EVT;
+    spans.authComplete = ESP_GAP_BLE_AUTH_CMPL_EVT;
+    return spans;
+}
@@ -0,0 +1,148 @@
+/*
+ * HTTP admission control
+ */
+
+#include <Arduino.h>
+#include "config.h"
+
+#if !HEADLESS_MODE
+
+#include "http_admission.h"
+
+struct TokenBucket {
+    uint32_t ip;
+    uint32_t lastRefill;    // millis()
+    uint32_t lastSeen;
+    float tokens;
+};
+
+// An admitted request that has not disconnected yet
+struct InFlightSlot {
+    AsyncWebServerRequest* request;     // NULL when free; only compared, never dereferenced
+    uint32_t since;                     // millis()
+};
+
+// Written by the BLE callbacks only; readers derive the expiry themselves
+static volatile bool pairingActive = false;
+static volatile uint32_t pairingSince = 0;
+
+// Request handlers all run on the AsyncTCP task, so the bucket table and
+// in-flight slots need no locking.
+static TokenBucket buckets[HTTP_RATE_CLIENTS];
+static InFlightSlot inFlight[HTTP_MAX_CONCURRENT];
+static HttpAdmissionStats stats = {};
+
+void http_admission_set_pairing(bool active) {
+    pairingSince = millis();
+    pairingActive = active;
+}
+
+bool http_admission_pairing_active() {
+    // A link that never completes pairing must not lock the web UI out forever
+    return pairingActive && millis() - pairingSince <= HTTP_PAIRING_MAX_HOLD_MS;
+}
+
+// A free slot for a new admitted request, or NULL at the cap. A slot whose
+// disconnect never arrived (a handler replaced the request's onDisconnect
+// hook) is reclaimed after HTTP_IN_FLIGHT_MAX_MS instead of leaking.
+static InFlightSlot* claimSlot(AsyncWebServerRequest *request) {
+    uint32_t now = millis();
+    for (int i = 0; i < HTTP_MAX_CONCURRENT; i++) {
+        InFlightSlot& slot = inFlight[i];
+        if (slot.request && now - slot.since > HTTP_IN_FLIGHT_MAX_MS) {
+            stats.expired++;
+            slot.request = NULL;
+        }
+        if (!slot.request) {
+            slot.request = request;
+            slot.since = now;
+            return &slot;
+        }
+    }
+    return NULL;
+}
+
+static void releaseSlot(AsyncWebServerRequest *request) {
+    for (int i = 0; i < HTTP_MAX_CONCURRENT; i++) {
+        if (inFlight[i].request == request) {
+            inFlight[i].request = NULL;
+            return;
+        }
+    }
+}
+
+static TokenBucket* bucketFor(uint32_t ip) {
+    TokenBucket* oldest = &buckets[0];
+    for (int i = 0; i < HTTP_RATE_CLIENTS; i++) {
+        if (buckets[i].ip == ip) return &buckets[i];
+        if (buckets[i].lastSeen < oldest->lastSeen) oldest = &buckets[i];
+    }
+
+    // Recycle the least recently seen slot for a new client
+    oldest->ip = ip;
+    oldest->lastRefill = millis();
+    oldest->tokens = HTTP_RATE_BURST;
+    return oldest;
+}
+
+static bool takeToken(uint32_t ip) {
+    TokenBucket* b = bucketFor(ip);
+    uint32_t now = millis();
+
+    b->tokens += (now - b->lastRefill) * (HTTP_RATE_PER_SEC / 1000.0f);
+    if (b->tokens > HTTP_RATE_BURST) b->tokens = HTTP_RATE_BURST;
+    b->lastRefill = now;
+    b->lastSeen = now;
+
+    if (b->tokens < 1.0f) return false;
+    b->tokens -= 1.0f;
+    return true;
+}
+
+static void reject(AsyncWebServerRequest *request, int code, int retryAfter) {
+    AsyncWebServerResponse *response = request->beginResponse(code, "application/json",
+        code == 429 ? "{\"error\":\"rate_limited\"}" : "{\"error\":\"busy\"}");
+    response->addHeader("Retry-After", String(retryAfter));
+    response->addHeader("Connection", "close");
+    request->send(response);
+}
+
+ArRequestHandlerFunction admitted(ArRequestHandlerFunction handler) {
+    return [handler](AsyncWebServerRequest *request) {
+        if (http_admission_pairing_active()) {
+            stats.rejectedPairing++;
+            reject(request, 503, HTTP_PAIRING_RETRY_AFTER);
+            return;
+        }
+
+        InFlightSlot* slot = claimSlot(request);
+        if (!slot) {
+            stats.rejectedBusy++;
+            reject(request, 503, 1);
+            return;
+        }
+
+        if (!takeToken((uint32_t)request->client()->remoteIP())) {
+            slot->request = NULL;
+            stats.rejectedRate++;
+            reject(request, 429, 1);
+            return;
+        }
+
+        // The request is freed right after its disconnect callback runs
+        stats.admitted++;
+        request->onDisconnect([request]() { releaseSlot(request); });
+        handler(request);
+    };
+}
+
+HttpAdmissionStats http_admission_stats() {
+    HttpAdmissionStats s = stats;
+    s.inFlight = 0;
+    for (int i = 0; i < HTTP_MAX_CONCURRENT; i++) {
+        if (inFlight[i].request) s.inFlight++;
+    }
+    return s;
+}
+
+#endif
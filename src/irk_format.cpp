@@ -0,0 +1,55 @@
+/*
+ * IRK output formats
+ */
+
+#include <stdio.h>
+#include "irk_format.h"
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+static void formatHex(const uint8_t* irk, char* out, bool reversed) {
+    for (int i = 0; i < 16; i++) {
+        uint8_t b = irk[reversed ? 15 - i : i];
+        out[i * 2] = HEX_DIGITS[b >> 4];
+        out[i * 2 + 1] = HEX_DIGITS[b & 0x0F];
+    }
+    out[32] = '\0';
+}
+
+// Encode bytes to Base64; out needs 4 * ceil(length / 3) + 1 bytes
+static void base64Encode(const uint8_t* data, size_t length, char* out) {
+    const char* table = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    for (size_t i = 0; i < length; i += 3) {
+        uint32_t value = data[i] << 16;
+        if (i + 1 < length) value |= data[i + 1] << 8;
+        if (i + 2 < length) value |= data[i + 2];
+
+        *out++ = table[(value >> 18) & 0x3F];
+        *out++ = table[(value >> 12) & 0x3F];
+        *out++ = (i + 1 < length) ? table[(value >> 6) & 0x3F] : '=';
+        *out++ = (i + 2 < length) ? table[value & 0x3F] : '=';
+    }
+    *out = '\0';
+}
+
+// Format IRK as a C hex array
+static void formatArray(const uint8_t* irk, char* out) {
+    for (int i = 0; i < 16; i++) {
+        if (i > 0) *out++ = ',';
+        *out++ = '0';
+        *out++ = 'x';
+        *out++ = HEX_DIGITS[irk[i] >> 4];
+        *out++ = HEX_DIGITS[irk[i] & 0x0F];
+    }
+    *out = '\0';
+}
+
+void irk_format_record(IrkRecord& r) {
+    snprintf(r.mac, sizeof(r.mac), "%02X:%02X:%02X:%02X:%02X:%02X",
+             r.identity[0], r.identity[1], r.identity[2], r.identity[3], r.identity[4], r.identity[5]);
+    formatHex(r.irk, r.hex, false);
+    formatHex(r.irk, r.reversed, true);
+    base64Encode(r.irk, 16, r.base64);
+    formatArray(r.irk, r.array);
+}
@@ -0,0 +1,93 @@
+/*
+ * Identity address / IRK index of paired devices
+ */
+
+#include <Arduino.h>
+#include <ctype.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "config.h"
+#include "irk_index.h"
+
+static irkstore::Store<IRK_STORE_CAPACITY> store;
+static SemaphoreHandle_t lock = NULL;
+
+void irk_index_begin() {
+    if (!lock) {
+        lock = xSemaphoreCreateMutex();
+    }
+}
+
+irkstore::UpsertResult irk_index_record(const uint8_t* addr, uint8_t addrType, const uint8_t* irk,
+                                        irkstore::Record* record) {
+    const irkstore::Record* stored = NULL;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    irkstore::UpsertResult result = store.upsert(addr, addrType, irk, millis(), &stored);
+    if (stored && record) *record = *stored;
+    xSemaphoreGive(lock);
+    return result;
+}
+
+void irk_index_seed(const uint8_t* addr, uint8_t addrType, const uint8_t* irk) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    store.seed(addr, addrType, irk, millis());
+    xSemaphoreGive(lock);
+}
+
+bool irk_index_find(const uint8_t* addr, irkstore::Record* record) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    const irkstore::Record* stored = store.findByAddr(addr);
+    if (stored && record) *record = *stored;
+    xSemaphoreGive(lock);
+    return stored != NULL;
+}
+
+bool irk_index_remove(const uint8_t* addr) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    bool removed = store.remove(addr);
+    xSemaphoreGive(lock);
+    return removed;
+}
+
+void irk_index_clear() {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    store.clear();
+    xSemaphoreGive(lock);
+}
+
+uint16_t irk_index_count() {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    uint16_t n = store.size();
+    xSemaphoreGive(lock);
+    return n;
+}
+
+// Longest query that can match: the 32-digit IRK hex
+static const size_t QUERY_MAX = 32;
+
+uint16_t irk_index_page(const uint8_t* after, const char* query, irkstore::Record* out, uint16_t max,
+                        bool* more) {
+    char needle[QUERY_MAX + 1];
+    size_t len = query ? strlen(query) : 0;
+    if (len > QUERY_MAX) {
+        if (more) *more = false;
+        return 0;
+    }
+    for (size_t i = 0; i < len; i++) needle[i] = (char)tolower((unsigned char)query[i]);
+    needle[len] = '\0';
+
+    auto match = [&](const irkstore::Record& r) {
+        if (len == 0) return true;
+        char text[33];
+        snprintf(text, sizeof(text), "%02x:%02x:%02x:%02x:%02x:%02x",
+                 r.addr[0], r.addr[1], r.addr[2], r.addr[3], r.addr[4], r.addr[5]);
+        if (strstr(text, needle)) return true;
+        for (int i = 0; i < 16; i++) snprintf(text + i * 2, 3, "%02x", r.irk[i]);
+        return strstr(text, needle) != NULL;
+    };
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    uint16_t n = store.page(after, out, max, more, match);
+    xSemaphoreGive(lock);
+    return n;
+}
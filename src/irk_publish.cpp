@@ -0,0 +1,90 @@
+/*
+ * Single-pass IRK publication
+ */
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "config.h"
+#include "irk_publish.h"
+
+static irk_publish_sink_t publishSink = NULL;
+static SemaphoreHandle_t lock = NULL;
+static IrkPublishStats stats = {};
+static IrkRecord record;
+
+// IRKs published so far; the oldest is forgotten when full
+static uint8_t seen[IRK_STORE_CAPACITY][16];
+static uint16_t seenCount = 0;
+static uint16_t seenNext = 0;
+
+void irk_publish_begin(irk_publish_sink_t sink) {
+    publishSink = sink;
+    if (!lock) {
+        lock = xSemaphoreCreateMutex();
+    }
+}
+
+static bool alreadySeen(const uint8_t* irk) {
+    for (uint16_t i = 0; i < seenCount; i++) {
+        if (memcmp(seen[i], irk, 16) == 0) return true;
+    }
+    return false;
+}
+
+bool irk_publish(const uint8_t* addr, const uint8_t* identity, uint8_t addrType, const uint8_t* irk,
+                 bool fromKeyExchange) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    stats.captures++;
+
+    if (alreadySeen(irk)) {
+        stats.duplicates++;
+        xSemaphoreGive(lock);
+        return false;
+    }
+
+    memcpy(seen[seenNext], irk, 16);
+    seenNext = (seenNext + 1) % IRK_STORE_CAPACITY;
+    if (seenCount < IRK_STORE_CAPACITY) seenCount++;
+
+    memcpy(record.addr, addr, 6);
+    memcpy(record.identity, identity, 6);
+    record.addrType = addrType;
+    memcpy(record.irk, irk, 16);
+    irk_format_record(record);
+    stats.formatted++;
+
+    // The sink runs under the lock so two captures never interleave output
+    if (publishSink) {
+        publishSink(record, fromKeyExchange);
+        stats.published++;
+    }
+    xSemaphoreGive(lock);
+    return true;
+}
+
+void irk_publish_reset() {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    seenCount = 0;
+    seenNext = 0;
+    xSemaphoreGive(lock);
+}
+
+void irk_publish_forget(const uint8_t* irk) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (uint16_t i = 0; i < seenCount; i++) {
+        if (memcmp(seen[i], irk, 16) == 0) {
+            // Zero the key instead of compacting, so the ring order holds
+            memset(seen[i], 0, 16);
+            break;
+        }
+    }
+    xSemaphoreGive(lock);
+}
+
+IrkPublishStats irk_publish_stats() {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    IrkPublishStats s = stats;
+    xSemaphoreGive(lock);
+    return s;
+}
@@ -0,0 +1,241 @@
+/*
+ * UDP log and IRK event shipper
+ */
+
+#include <Arduino.h>
+#include "config.h"
+#include "log_shipper.h"
+
+#if LOG_SHIP_ENABLED && !HEADLESS_MODE
+
+#ifndef USE_ESP_IDF_LOG
+#warning "LOG_SHIP_ENABLED without USE_ESP_IDF_LOG: ESP_LOGx output does not reach esp_log and is not shipped"
+#endif
+
+#include <stdarg.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "log_ring.h"
+
+#define LOG_SHIP_TAG "LOGSHIP"
+
+// RFC 5424 facility local0
+#define LOG_SHIP_FACILITY 16
+
+// esp_log levels in order; LOG_SHIP_LEVEL 1 ships errors only
+static const char LEVELS[] = "EWIDV";
+
+typedef logring::Ring<LOG_SHIP_RING_SLOTS, LOG_SHIP_LINE_MAX> ShipRing;
+
+// Written from any task by the log hook, read by the sender
+static ShipRing ring;
+static portMUX_TYPE ringMux = portMUX_INITIALIZER_UNLOCKED;
+
+static vprintf_like_t previousVprintf = NULL;
+static TaskHandle_t shipTask = NULL;
+static volatile bool benchRunning = false;
+static LogShipperStats stats = {};
+static char host[64];
+
+static bool push(uint8_t kind, const char* text, size_t len) {
+    uint32_t ms = millis();
+    portENTER_CRITICAL(&ringMux);
+    bool ok = ring.push(ms, kind, text, len);
+    portEXIT_CRITICAL(&ringMux);
+    return ok;
+}
+
+// esp_log output still goes to the previous sink (the UART); a copy of every
+// line at or below LOG_SHIP_LEVEL goes into the ring. Lines logged by the
+// sender itself (lwIP, WiFi) are not shipped, so sending cannot feed itself.
+static int shipVprintf(const char* fmt, va_list args) {
+    va_list copy;
+    va_copy(copy, args);
+    int ret = previousVprintf(fmt, args);
+
+    if (xTaskGetCurrentTaskHandle() != shipTask) {
+        char line[LOG_SHIP_LINE_MAX];
+        int n = vsnprintf(line, sizeof(line), fmt, copy);
+        if (n > 0) {
+            size_t len = (size_t)n < sizeof(line) ? (size_t)n : sizeof(line) - 1;
+            const char* level = strchr(LEVELS, logring::parseLogLine(line, len).level);
+            if (level && level - LEVELS + 1 <= LOG_SHIP_LEVEL) {
+                push(logring::KIND_LOG, line, len);
+            }
+        }
+    }
+    va_end(copy);
+    return ret;
+}
+
+static size_t format(const ShipRing::Entry& e, char* out, size_t cap) {
+#if LOG_SHIP_FORMAT
+    return logring::formatJson(e, host, out, cap);
+#else
+    return logring::formatSyslog(e, host, LOG_SHIP_FACILITY, out, cap);
+#endif
+}
+
+static void sendDatagram(WiFiUDP& udp, const IPAddress& collector, const char* data, size_t len) {
+    udp.beginPacket(collector, LOG_SHIP_PORT);
+    udp.write((const uint8_t*)data, len);
+    if (udp.endPacket()) {
+        stats.datagrams++;
+    } else {
+        stats.sendErrors++;
+    }
+}
+
+static void shipperTask(void* arg) {
+    WiFiUDP udp;
+    IPAddress collector;
+    bool resolved = false;
+    uint32_t reportedDrops = 0;
+    // Task-owned, so the stack only holds the entry being formatted
+    static char datagram[LOG_SHIP_DATAGRAM_MAX];
+    static char out[LOG_SHIP_DATAGRAM_MAX];
+    ShipRing::Entry e;
+
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(LOG_SHIP_FLUSH_MS));
+
+        // Until WiFi is up the ring holds the newest records and counts the rest
+        if (WiFi.status() != WL_CONNECTED) {
+            stats.connected = false;
+            continue;
+        }
+        if (!resolved) {
+            resolved = collector.fromString(LOG_SHIP_HOST) || WiFi.hostByName(LOG_SHIP_HOST, collector) == 1;
+            if (!resolved) continue;
+            ESP_LOGI(LOG_SHIP_TAG, "Shipping to %s:%d", collector.toString().c_str(), LOG_SHIP_PORT);
+        }
+        stats.connected = true;
+
+        // Drops since the last wake-up go first, as one record without a
+        // sequence number of its own
+        portENTER_CRITICAL(&ringMux);
+        uint32_t dropped = ring.dropped();
+        portEXIT_CRITICAL(&ringMux);
+        if (dropped != reportedDrops) {
+            ShipRing::Entry drop = {};
+            drop.ms = millis();
+            drop.kind = logring::KIND_DROP;
+            drop.len = (uint8_t)snprintf(drop.text, sizeof(drop.text), "%lu",
+                                         (unsigned long)(dropped - reportedDrops));
+            reportedDrops = dropped;
+            size_t n = format(drop, out, sizeof(out));
+            if (n) sendDatagram(udp, collector, out, n);
+        }
+
+        // Syslog over UDP is one message per datagram (RFC 5426); JSON lines
+        // are packed up to LOG_SHIP_DATAGRAM_MAX
+        size_t fill = 0;
+        for (;;) {
+            portENTER_CRITICAL(&ringMux);
+            bool more = ring.pop(e);
+            portEXIT_CRITICAL(&ringMux);
+            if (!more) break;
+
+            size_t n = format(e, out, sizeof(out));
+            if (n == 0) continue;
+            stats.sent++;
+#if LOG_SHIP_FORMAT
+            if (fill + n > sizeof(datagram)) {
+                sendDatagram(udp, collector, datagram, fill);
+                fill = 0;
+            }
+            memcpy(datagram + fill, out, n);
+            fill += n;
+#else
+            sendDatagram(udp, collector, out, n);
+#endif
+        }
+        if (fill > 0) sendDatagram(udp, collector, datagram, fill);
+    }
+}
+
+void log_shipper_begin(const char* hostname) {
+    strncpy(host, hostname, sizeof(host) - 1);
+    xTaskCreateUniversal(shipperTask, "logship", 4096, NULL, TASK_PRIO_LOGSHIP, &shipTask, TASK_CORE_LOGSHIP);
+    previousVprintf = esp_log_set_vprintf(shipVprintf);
+    Serial.printf("Log shipper started (collector %s:%d, %s)\n", LOG_SHIP_HOST, LOG_SHIP_PORT,
+                  LOG_SHIP_FORMAT ? "JSON lines" : "syslog");
+}
+
+bool log_shipper_enqueue_irk(const IrkRecord& record, bool fromKeyExchange) {
+    if (!shipTask) return false;
+
+    char text[80];
+    int n = snprintf(text, sizeof(text), "%s %s %s", record.mac, record.hex,
+                     fromKeyExchange ? "key_exchange" : "bond");
+    return push(logring::KIND_IRK, text, (size_t)n);
+}
+
+LogShipperStats log_shipper_stats() {
+    LogShipperStats s = stats;
+    portENTER_CRITICAL(&ringMux);
+    s.queued = ring.pushed();
+    s.dropped = ring.dropped();
+    portEXIT_CRITICAL(&ringMux);
+    s.benchRunning = benchRunning;
+    return s;
+}
+
+struct BenchArgs {
+    uint32_t rate;
+    uint32_t seconds;
+};
+
+static BenchArgs benchArgs;
+
+// Paced in 10 ms steps, bypassing esp_log so the UART does not set the rate
+static void benchTask(void* arg) {
+    const uint32_t stepMs = 10;
+    uint32_t steps = benchArgs.seconds * 1000 / stepMs;
+    uint64_t offered = 0;
+    char line[64];
+    TickType_t wake = xTaskGetTickCount();
+
+    for (uint32_t step = 1; step <= steps; step++) {
+        uint64_t due = (uint64_t)benchArgs.rate * step * stepMs / 1000;
+        for (; offered < due; offered++) {
+            int n = snprintf(line, sizeof(line), "I (%lu) BENCH: record %lu\n", (unsigned long)millis(),
+                             (unsigned long)offered);
+            push(logring::KIND_LOG, line, (size_t)n);
+        }
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(stepMs));
+    }
+    benchRunning = false;
+    vTaskDelete(NULL);
+}
+
+bool log_shipper_bench(uint32_t rate, uint32_t seconds) {
+    if (!shipTask || benchRunning) return false;
+    benchRunning = true;
+    benchArgs.rate = rate;
+    benchArgs.seconds = seconds;
+    xTaskCreateUniversal(benchTask, "logbench", 3072, NULL, TASK_PRIO_LOGSHIP, NULL, TASK_CORE_LOGSHIP);
+    return true;
+}
+
+#else
+
+void log_shipper_begin(const char* hostname) {}
+
+bool log_shipper_enqueue_irk(const IrkRecord& record, bool fromKeyExchange) {
+    return false;
+}
+
+LogShipperStats log_shipper_stats() {
+    LogShipperStats none = {};
+    return none;
+}
+
+bool log_shipper_bench(uint32_t rate, uint32_t seconds) {
+    return false;
+}
+
+#endif
@@ -4,6 +4,7 @@
  */
 
 #include <Arduino.h>
+#include <new>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
@@ -16,34 +17,74 @@
 #include "esp_bt_defs.h"
 #include "esp_bt_main.h"
 #include "esp_bt_device.h"
+#include "esp_timer.h"
 #include "esp32-hal.h"
 
+#include "config.h"
+#include "app_config.h"
+#include "irk_format.h"
+#include "irk_publish.h"
+#include "mqtt_publisher.h"
+#include "log_shipper.h"
+#include "serial_link.h"
+#include "deferred_jobs.h"
+#include "coex_policy.h"
+#include "pairing_stats.h"
+#include "sc_ecc.h"
+#include "irk_index.h"
+#include "rpa_service.h"
+#include "conn_params.h"
+#include "event_trace.h"
+#include "task_monitor.h"
+
+#if !HEADLESS_MODE
 #include <WiFi.h>
 #include <ESPAsyncWebServer.h>
 #include <AsyncTCP.h>
 #include <Preferences.h>
 #include <ArduinoJson.h>
+#if CAPTIVE_DNS_ENABLED && AP_MODE_ENABLED
 #include <DNSServer.h>
+#endif
+#if MDNS_ENABLED
 #include <ESPmDNS.h>
-#include "config.h"
+#endif
+#include "esp_wifi.h"
+#include "http_admission.h"
+#include "json_writer.h"
+#include "ota_update.h"
+#include "wifi_scan.h"
 
 // Web server
-AsyncWebServer server(WEB_SERVER_PORT);
+AsyncWebServer server(APP_CONFIG.net.webPort);
 
+#if CAPTIVE_DNS_ENABLED && AP_MODE_ENABLED
 // DNS server for captive portal
 DNSServer dnsServer;
 const byte DNS_PORT = 53;
 
+// Answers captive portal lookups while in AP mode, off the loop() task
+static void dnsTask(void* param) {
+    for (;;) {
+        dnsServer.processNextRequest();
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+#endif
+
 // Preferences for storing WiFi credentials
 Preferences preferences;
 
-// mDNS hostname
-const char* mdnsHostname = "esp32-irk-finder";
-
 // WiFi configuration
 String stored_ssid = "";
 String stored_password = "";
+#if AP_MODE_ENABLED
 bool isAPMode = false;
+#else
+// Never true, so the AP branches below fold away
+static constexpr bool isAPMode = false;
+#endif
+#endif
 
 // Global IRK storage
 String currentIRK = "No IRK retrieved yet";
@@ -52,54 +93,13 @@ String currentIRKReversed = "";
 String currentIRKArray = "";
 String connectedDeviceMAC = "None";
 bool irkRetrieved = false;
-
-// Helper function to encode bytes to Base64
-String base64Encode(const uint8_t* data, size_t length) {
-    const char* table = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-    String result;
-
-    for (size_t i = 0; i < length; i += 3) {
-        uint32_t value = data[i] << 16;
-        if (i + 1 < length) value |= data[i + 1] << 8;
-        if (i + 2 < length) value |= data[i + 2];
-
-        result += table[(value >> 18) & 0x3F];
-        result += table[(value >> 12) & 0x3F];
-        result += (i + 1 < length) ? table[(value >> 6) & 0x3F] : '=';
-        result += (i + 2 < length) ? table[value & 0x3F] : '=';
-    }
-
-    return result;
-}
-
-// Helper function to reverse IRK bytes for ESPresense
-String reverseIRK(const uint8_t* irk) {
-    char reversed[33];
-    for (int i = 0; i < 16; i++) {
-        sprintf(&reversed[i * 2], "%02x", irk[15 - i]);
-    }
-    reversed[32] = '\0';
-    return String(reversed);
-}
-
-// Helper function to format IRK as hex array
-String formatIRKArray(const uint8_t* irk) {
-    String result = "";
-    for (int i = 0; i < 16; i++) {
-        if (i > 0) result += ",";
-        char hex[6];
-        sprintf(hex, "0x%02x", irk[i]);
-        result += hex;
-    }
-    return result;
-}
+uint16_t currentPairCount = 0;      // times the current device has paired since boot
 
 // BLE Configuration
 #define GATTS_TABLE_TAG "ESP32_IRK"
 #define HEART_PROFILE_NUM                         1
 #define HEART_PROFILE_APP_IDX                     0
 #define ESP_HEART_RATE_APP_ID                     0x55
-#define EXAMPLE_DEVICE_NAME                       "ESP32_IRK_FINDER"
 #define HEART_RATE_SVC_INST_ID                    0
 
 #define ADV_CONFIG_FLAG                           (1 << 0)
@@ -108,6 +108,18 @@ String formatIRKArray(const uint8_t* irk) {
 static uint8_t adv_config_done = 0;
 
 // Attributes State Machine
+#if GATT_DB_MINIMAL
+// One encrypted-read characteristic: the least a phone has to discover
+enum {
+    SEC_IDX_SVC,
+    SEC_IDX_CHAR,
+    SEC_IDX_VAL,
+    SEC_IDX_NB,
+};
+
+#define GATT_IDX_SVC SEC_IDX_SVC
+#define GATT_IDX_NB SEC_IDX_NB
+#else
 enum {
     HRS_IDX_SVC,
     HRS_IDX_HR_MEAS_CHAR,
@@ -120,9 +132,15 @@ enum {
     HRS_IDX_NB,
 };
 
-static uint16_t heart_rate_handle_table[HRS_IDX_NB];
+#define GATT_IDX_SVC HRS_IDX_SVC
+#define GATT_IDX_NB HRS_IDX_NB
+#endif
+
+static uint16_t gatt_handle_table[GATT_IDX_NB];
 static uint8_t test_manufacturer[3] = {'E', 'S', 'P'};
 
+// Heart Rate (0x180D) in 128-bit base UUID form, advertised in both table
+// layouts and used as the minimal table's service
 static uint8_t sec_service_uuid[16] = {
     0xfb, 0x34, 0x9b, 0x5f, 0x80, 0x00, 0x00, 0x80,
     0x00, 0x10, 0x00, 0x00, 0x18, 0x0D, 0x00, 0x00,
@@ -170,13 +188,23 @@ static const uint8_t char_prop_notify = ESP_GATT_CHAR_PROP_BIT_NOTIFY;
 static const uint8_t char_prop_read = ESP_GATT_CHAR_PROP_BIT_READ;
 static const uint8_t char_prop_read_write = ESP_GATT_CHAR_PROP_BIT_WRITE | ESP_GATT_CHAR_PROP_BIT_READ;
 
+#if GATT_DB_MINIMAL
+// ea44d0a2-1fab-48d9-a8a6-5dab387b43a0, LSB first
+static const uint8_t sec_char_uuid[16] = {
+    0xa0, 0x43, 0x7b, 0x38, 0xab, 0x5d, 0xa6, 0xa8,
+    0xd9, 0x48, 0xab, 0x1f, 0xa2, 0xd0, 0x44, 0xea,
+};
+static const uint8_t sec_char_val[1] = {0x01};
+#else
 static const uint16_t heart_rate_meas_uuid = ESP_GATT_HEART_RATE_MEAS;
 static const uint8_t heart_measurement_ccc[2] = {0x00, 0x00};
 static const uint16_t body_sensor_location_uuid = ESP_GATT_BODY_SENSOR_LOCATION;
 static const uint8_t body_sensor_loc_val[1] = {0x00};
 static const uint16_t heart_rate_ctrl_point = ESP_GATT_HEART_RATE_CNTL_POINT;
 static const uint8_t heart_ctrl_point[1] = {0x00};
+#endif
 
+#if !HEADLESS_MODE && WEB_UI_ENABLED
 // HTML page for web interface
 const char index_html[] PROGMEM = R"rawliteral(
 <!DOCTYPE HTML>
@@ -410,6 +438,54 @@ const char index_html[] PROGMEM = R"rawliteral(
             font-size: 0.875rem;
         }
 
+        .device-toolbar {
+            display: flex;
+            align-items: center;
+            gap: 0.5rem;
+            margin-bottom: 0.75rem;
+        }
+
+        .device-list {
+            position: relative;
+            height: 16rem;
+            overflow-y: auto;
+            border: 1px solid var(--border);
+            border-radius: calc(var(--radius) - 2px);
+        }
+
+        .device-row {
+            position: absolute;
+            left: 0;
+            right: 0;
+            height: 44px;
+            display: flex;
+            align-items: center;
+            gap: 0.5rem;
+            padding: 0 0.75rem;
+            border-bottom: 1px solid var(--border);
+            font-size: 0.75rem;
+        }
+
+        .device-row .mono {
+            font-family: 'SF Mono', 'Monaco', 'Inconsolata', 'Fira Code', monospace;
+            overflow: hidden;
+            text-overflow: ellipsis;
+            white-space: nowrap;
+        }
+
+        .device-row .irk {
+            flex: 1;
+            color: var(--muted-foreground);
+        }
+
+        .badge {
+            padding: 0.125rem 0.375rem;
+            border-radius: 0.25rem;
+            background: var(--muted);
+            color: var(--muted-foreground);
+            white-space: nowrap;
+        }
+
         .hidden {
             display: none;
         }
@@ -493,6 +569,12 @@ const char index_html[] PROGMEM = R"rawliteral(
                     if (data.isAPMode && wifiConfigDiv) {
                         wifiConfigDiv.classList.remove('hidden');
                     }
+
+                    // Re-read the device table only when a device was added or removed
+                    if (data.knownDevices !== knownDevices) {
+                        knownDevices = data.knownDevices;
+                        loadDevices(true);
+                    }
                 });
         }
 
@@ -514,8 +596,125 @@ const char index_html[] PROGMEM = R"rawliteral(
             }
         }
 
+        // Device table: only the rows in view exist in the DOM, and pages
+        // are fetched from /api/devices as the list scrolls towards the end
+        const ROW_HEIGHT = 44;
+        const PAGE_SIZE = 8;
+        let devices = [];
+        let deviceCursor = null;
+        let deviceMore = true;
+        let deviceLoading = false;
+        let deviceTotal = 0;
+        let deviceQuery = '';
+        let deviceGeneration = 0;
+        let knownDevices = -1;
+        let searchTimer = null;
+
+        function loadDevices(reset) {
+            if (reset) {
+                devices = [];
+                deviceCursor = null;
+                deviceMore = true;
+                deviceGeneration++;
+                document.getElementById('device-list').scrollTop = 0;
+            }
+            if (deviceLoading || !deviceMore) {
+                renderDevices();
+                return;
+            }
+            deviceLoading = true;
+            const generation = deviceGeneration;
+            let url = '/api/devices?limit=' + PAGE_SIZE;
+            if (deviceCursor) url += '&cursor=' + encodeURIComponent(deviceCursor);
+            if (deviceQuery) url += '&q=' + encodeURIComponent(deviceQuery);
+            fetch(url)
+                .then(response => response.ok ? response.json() : Promise.reject(response.status))
+                .then(data => {
+                    deviceLoading = false;
+                    if (generation !== deviceGeneration) return loadDevices(false);
+                    devices = devices.concat(data.devices);
+                    deviceCursor = data.next;
+                    deviceMore = data.next !== null;
+                    deviceTotal = data.total;
+                    renderDevices();
+                })
+                .catch(() => {
+                    // Busy or rate limited; the next scroll or status change retries
+                    deviceLoading = false;
+                });
+        }
+
+        function renderDevices() {
+            const list = document.getElementById('device-list');
+            const spacer = document.getElementById('device-spacer');
+            const rows = devices.length + (deviceMore ? 1 : 0);
+            spacer.style.height = (rows * ROW_HEIGHT) + 'px';
+
+            const first = Math.max(0, Math.floor(list.scrollTop / ROW_HEIGHT) - 2);
+            const last = Math.min(rows, Math.ceil((list.scrollTop + list.clientHeight) / ROW_HEIGHT) + 2);
+            spacer.textContent = '';
+            for (let i = first; i < last; i++) {
+                const row = document.createElement('div');
+                row.className = 'device-row';
+                row.style.top = (i * ROW_HEIGHT) + 'px';
+                if (i >= devices.length) {
+                    row.textContent = 'Loading...';
+                } else {
+                    const d = devices[i];
+                    const addr = document.createElement('span');
+                    addr.className = 'mono';
+                    addr.textContent = d.address;
+                    const irk = document.createElement('span');
+                    irk.className = 'mono irk';
+                    irk.textContent = d.irk;
+                    const badge = document.createElement('span');
+                    badge.className = 'badge';
+                    badge.textContent = (d.bonded ? 'bonded' : 'seen') + ' \u00d7' + d.pairCount;
+                    const del = document.createElement('button');
+                    del.className = 'btn btn-outline btn-copy';
+                    del.textContent = 'Delete';
+                    del.onclick = () => deleteDevice(d.address);
+                    row.append(addr, irk, badge, del);
+                }
+                spacer.appendChild(row);
+            }
+            document.getElementById('device-count').textContent =
+                devices.length + ' of ' + (deviceQuery ? 'matching' : deviceTotal) + ' shown';
+
+            if (deviceMore && !deviceLoading && last >= devices.length - 2) loadDevices(false);
+        }
+
+        function searchDevices(value) {
+            clearTimeout(searchTimer);
+            searchTimer = setTimeout(() => {
+                deviceQuery = value.trim();
+                loadDevices(true);
+            }, 300);
+        }
+
+        function deleteDevice(address) {
+            if (!confirm('Remove ' + address + ' and its bond?')) return;
+            fetch('/api/devices?address=' + encodeURIComponent(address), { method: 'DELETE' })
+                .then(response => response.json())
+                .then(data => {
+                    if (!data.success) {
+                        alert('Failed to remove device: ' + (data.error || 'Unknown error'));
+                        return;
+                    }
+                    devices = devices.filter(d => d.address !== address);
+                    deviceTotal = Math.max(0, deviceTotal - 1);
+                    renderDevices();
+                })
+                .catch(error => {
+                    alert('Error removing device: ' + error);
+                });
+        }
+
         setInterval(refreshData, 2000);
-        window.onload = refreshData;
+        window.onload = () => {
+            document.getElementById('device-list').onscroll = renderDevices;
+            refreshData();
+        };
     </script>
 </head>
 <body>
@@ -579,6 +778,20 @@ const char index_html[] PROGMEM = R"rawliteral(
             </div>
         </div>
 
+        <div class="card">
+            <div class="card-content">
+                <label class="label">Known Devices</label>
+                <p class="description">Bonded devices and devices paired since boot</p>
+                <div class="device-toolbar">
+                    <input id="device-search" class="input" placeholder="Search address or IRK" oninput="searchDevices(this.value)">
+                    <span id="device-count" class="description" style="margin-bottom: 0;"></span>
+                </div>
+                <div id="device-list" class="device-list">
+                    <div id="device-spacer" style="position: relative;"></div>
+                </div>
+            </div>
+        </div>
+
         <div id="reset-container" class="reset-container hidden">
             <button class="btn btn-danger" onclick="resetIRK()" style="padding: 0.625rem 2rem; width: auto;">Reset IRK</button>
             <p style="margin-top: 0.5rem; font-size: 0.875rem; color: var(--muted-foreground);">Clear IRK and remove all paired devices</p>
@@ -603,10 +816,10 @@ const char index_html[] PROGMEM = R"rawliteral(
                     </ul>
                 </li>
                 <li>Open the BLE scanner app and scan for devices</li>
-                <li>Look for <code>ESP32_IRK_FINDER</code> in the device list</li>
+                <li>Look for <code>)rawliteral" BLE_DEVICE_NAME R"rawliteral(</code> in the device list</li>
                 <li>Tap to connect</li>
                 <li>When prompted for pairing, accept the request</li>
-                <li>Enter passkey: <code>123456</code></li>
+                <li>Enter passkey: <code>)rawliteral" CONFIG_STR(BLE_PASSKEY) R"rawliteral(</code></li>
                 <li>After successful pairing, the IRK will appear above in multiple formats</li>
             </ol>
         </div>
@@ -767,6 +980,44 @@ const char wifi_html[] PROGMEM = R"rawliteral(
             });
         }
 
+        function loadNetworks(attempt = 0) {
+            fetch('/api/wifi/scan')
+                .then(response => response.json())
+                .then(data => {
+                    const list = document.getElementById('networks');
+                    if (data.networks.length > 0) {
+                        list.innerHTML = '';
+                        data.networks.forEach(net => {
+                            const item = document.createElement('div');
+                            item.className = 'network-item';
+                            const name = document.createElement('span');
+                            name.className = 'network-ssid';
+                            name.textContent = net.ssid;
+                            const rssi = document.createElement('span');
+                            rssi.className = 'network-rssi';
+                            rssi.textContent = net.rssi + ' dBm' + (net.secure ? ' \u{1F512}' : '');
+                            item.appendChild(name);
+                            item.appendChild(rssi);
+                            item.onclick = () => {
+                                document.getElementById('ssid').value = net.ssid;
+                                document.getElementById('password').focus();
+                            };
+                            list.appendChild(item);
+                        });
+                    } else if (!data.scanning) {
+                        list.innerHTML = '<div class="loading">No networks found</div>';
+                    }
+                    if (data.scanning && attempt < 10) {
+                        setTimeout(() => loadNetworks(attempt + 1), 1500);
+                    }
+                })
+                .catch(() => {
+                    if (attempt < 10) setTimeout(() => loadNetworks(attempt + 1), 3000);
+                });
+        }
+
+        window.addEventListener('load', () => loadNetworks());
+
         function clearWiFi() {
             if (confirm('Clear saved WiFi credentials?')) {
                 fetch('/api/wifi/clear', { method: 'POST' })
@@ -790,6 +1041,12 @@ const char wifi_html[] PROGMEM = R"rawliteral(
 
         <div class="card">
             <div class="card-content">
+                <div class="form-group">
+                    <label class="label">Nearby Networks</label>
+                    <div id="networks" class="networks-list">
+                        <div class="loading">Scanning...</div>
+                    </div>
+                </div>
                 <div class="form-group">
                     <label class="label" for="ssid">WiFi SSID</label>
                     <input type="text" id="ssid" class="input" placeholder="Enter WiFi network name">
@@ -810,9 +1067,36 @@ const char wifi_html[] PROGMEM = R"rawliteral(
 </body>
 </html>
 )rawliteral";
+#endif
+
+#if GATT_DB_MINIMAL
+// Minimal Database Description: the advertised service UUID with a single
+// characteristic that can only be read over an encrypted link
+static const esp_gatts_attr_db_t gatt_db[GATT_IDX_NB] = {
+    // Service Declaration
+    [SEC_IDX_SVC] = {
+        {ESP_GATT_AUTO_RSP},
+        {ESP_UUID_LEN_16, (uint8_t *)&primary_service_uuid, ESP_GATT_PERM_READ,
+         sizeof(sec_service_uuid), sizeof(sec_service_uuid), (uint8_t *)sec_service_uuid}
+    },
 
+    // Characteristic Declaration
+    [SEC_IDX_CHAR] = {
+        {ESP_GATT_AUTO_RSP},
+        {ESP_UUID_LEN_16, (uint8_t *)&character_declaration_uuid, ESP_GATT_PERM_READ,
+         sizeof(uint8_t), sizeof(uint8_t), (uint8_t *)&char_prop_read}
+    },
+
+    // Characteristic Value
+    [SEC_IDX_VAL] = {
+        {ESP_GATT_AUTO_RSP},
+        {ESP_UUID_LEN_128, (uint8_t *)sec_char_uuid, ESP_GATT_PERM_READ_ENCRYPTED,
+         sizeof(sec_char_val), sizeof(sec_char_val), (uint8_t *)sec_char_val}
+    },
+};
+#else
 // Full HRS Database Description
-static const esp_gatts_attr_db_t heart_rate_gatt_db[HRS_IDX_NB] = {
+static const esp_gatts_attr_db_t gatt_db[GATT_IDX_NB] = {
     // Heart Rate Service Declaration
     [HRS_IDX_SVC] = {
         {ESP_GATT_AUTO_RSP},
@@ -869,8 +1153,45 @@ static const esp_gatts_attr_db_t heart_rate_gatt_db[HRS_IDX_NB] = {
          sizeof(uint8_t), sizeof(heart_ctrl_point), (uint8_t *)heart_ctrl_point}
     },
 };
+#endif
+
+// Publication sink: runs once per distinct IRK, whichever path captured it
+static void on_irk_published(const IrkRecord& record, bool fromKeyExchange) {
+    connectedDeviceMAC = record.mac;
+    currentIRK = record.hex;
+    currentIRKBase64 = record.base64;
+    currentIRKReversed = record.reversed;
+    currentIRKArray = record.array;
+    irkRetrieved = true;
+
+    ESP_LOGI(GATTS_TABLE_TAG, "=================================");
+    ESP_LOGI(GATTS_TABLE_TAG, "Device MAC: %s", record.mac);
+    ESP_LOGI(GATTS_TABLE_TAG, "IRK (Hex): %s", record.hex);
+    ESP_LOGI(GATTS_TABLE_TAG, "IRK (ESPresense): %s", record.reversed);
+    ESP_LOGI(GATTS_TABLE_TAG, "IRK (Base64): %s", record.base64);
+    ESP_LOGI(GATTS_TABLE_TAG, "=================================");
+
+    Serial.println("\n========================================");
+    Serial.println(fromKeyExchange ? "IRK RECEIVED VIA KEY EXCHANGE!" : "IRK SUCCESSFULLY RETRIEVED!");
+    Serial.printf("Identity Address: %s (%s)\n", record.mac, record.addrType ? "random static" : "public");
+    Serial.println("\n--- IRK Formats ---");
+    Serial.print("Standard Hex: ");
+    Serial.println(record.hex);
+    Serial.print("ESPresense (reversed): ");
+    Serial.println(record.reversed);
+    Serial.print("Base64 (HA Private BLE): ");
+    Serial.println(record.base64);
+    Serial.print("Hex Array: ");
+    Serial.println(record.array);
+    Serial.println("========================================\n");
+
+    serial_link_send_irk(record.identity, record.addrType, record.irk);
+    mqtt_publisher_enqueue_irk(record);
+    log_shipper_enqueue_irk(record, fromKeyExchange);
+}
 
-// Function to show bonded devices and extract IRK
+// Hand every bonded IRK to the publication stage; already published ones
+// are dropped there without being formatted again
 static void show_bonded_devices(void) {
     int dev_num = esp_ble_get_bond_device_num();
 
@@ -884,81 +1205,97 @@ static void show_bonded_devices(void) {
     ESP_LOGI(GATTS_TABLE_TAG, "Bonded devices: %d", dev_num);
 
     for (int i = 0; i < dev_num; i++) {
-        // Extract MAC address
-        char mac_str[18];
-        sprintf(mac_str, "%02X:%02X:%02X:%02X:%02X:%02X",
-                dev_list[i].bd_addr[0], dev_list[i].bd_addr[1],
-                dev_list[i].bd_addr[2], dev_list[i].bd_addr[3],
-                dev_list[i].bd_addr[4], dev_list[i].bd_addr[5]);
-
-        connectedDeviceMAC = String(mac_str);
-
-        // Extract IRK
-        char irk_str[33];
-        uint8_t* irk_bytes = dev_list[i].bond_key.pid_key.irk;
-
-        for(int j = 0; j < 16; j++) {
-            sprintf(&irk_str[j * 2], "%02x", irk_bytes[j]);
-        }
-        irk_str[32] = '\0';
-
-        currentIRK = String(irk_str);
-        currentIRKBase64 = base64Encode(irk_bytes, 16);
-        currentIRKReversed = reverseIRK(irk_bytes);
-        currentIRKArray = formatIRKArray(irk_bytes);
-        irkRetrieved = true;
-
-        ESP_LOGI(GATTS_TABLE_TAG, "=================================");
-        ESP_LOGI(GATTS_TABLE_TAG, "Device MAC: %s", mac_str);
-        ESP_LOGI(GATTS_TABLE_TAG, "IRK (Hex): %s", irk_str);
-        ESP_LOGI(GATTS_TABLE_TAG, "IRK (ESPresense): %s", currentIRKReversed.c_str());
-        ESP_LOGI(GATTS_TABLE_TAG, "IRK (Base64): %s", currentIRKBase64.c_str());
-        ESP_LOGI(GATTS_TABLE_TAG, "=================================");
-
-        Serial.println("\n========================================");
-        Serial.println("IRK SUCCESSFULLY RETRIEVED!");
-        Serial.print("Device MAC: ");
-        Serial.println(connectedDeviceMAC);
-        Serial.println("\n--- IRK Formats ---");
-        Serial.print("Standard Hex: ");
-        Serial.println(currentIRK);
-        Serial.print("ESPresense (reversed): ");
-        Serial.println(currentIRKReversed);
-        Serial.print("Base64 (HA Private BLE): ");
-        Serial.println(currentIRKBase64);
-        Serial.print("Hex Array: ");
-        Serial.println(currentIRKArray);
-        Serial.println("========================================\n");
+        // A peer that never distributed its identity key has no IRK
+        if (!(dev_list[i].bond_key.key_mask & ESP_BLE_ID_KEY_MASK)) continue;
+        const esp_ble_pid_keys_t& pid = dev_list[i].bond_key.pid_key;
+
+        // Bonds restored from NVS enter the index without counting as a pairing
+        irk_index_seed(pid.static_addr, pid.addr_type, pid.irk);
+        irk_publish(dev_list[i].bd_addr, pid.static_addr, pid.addr_type, pid.irk, false);
     }
 
     free(dev_list);
 }
 
-// Remove all bonded devices
+// Clear the IRK shown on the web page and in /api/status
+static void clear_current_irk(void) {
+    currentIRK = "No IRK retrieved yet";
+    currentIRKBase64 = "";
+    currentIRKReversed = "";
+    currentIRKArray = "";
+    connectedDeviceMAC = "None";
+    irkRetrieved = false;
+    currentPairCount = 0;
+}
+
+// Remove all bonded devices, and every device the index still remembers
 static void remove_all_bonded_devices(void) {
     int dev_num = esp_ble_get_bond_device_num();
 
-    if(dev_num == 0) return;
+    if (dev_num > 0) {
+        esp_ble_bond_dev_t *dev_list = (esp_ble_bond_dev_t *)malloc(sizeof(esp_ble_bond_dev_t) * dev_num);
+        esp_ble_get_bond_device_list(&dev_num, dev_list);
 
-    esp_ble_bond_dev_t *dev_list = (esp_ble_bond_dev_t *)malloc(sizeof(esp_ble_bond_dev_t) * dev_num);
-    esp_ble_get_bond_device_list(&dev_num, dev_list);
+        for (int i = 0; i < dev_num; i++) {
+            esp_ble_remove_bond_device(dev_list[i].bd_addr);
+            serial_link_send_bond_removed(dev_list[i].bd_addr);
+        }
 
-    for (int i = 0; i < dev_num; i++) {
-        esp_ble_remove_bond_device(dev_list[i].bd_addr);
+        free(dev_list);
     }
 
-    free(dev_list);
+    clear_current_irk();
+    irk_index_clear();
+    irk_publish_reset();
+    rpa_service_invalidate();
+}
 
-    currentIRK = "No IRK retrieved yet";
-    currentIRKBase64 = "";
-    currentIRKReversed = "";
-    currentIRKArray = "";
-    connectedDeviceMAC = "None";
-    irkRetrieved = false;
+#if !HEADLESS_MODE
+// A bond belongs to a device if it was made under that address or carries
+// it as the identity address
+static bool bond_matches(const esp_ble_bond_dev_t& dev, const uint8_t* identity) {
+    if (memcmp(dev.bd_addr, identity, 6) == 0) return true;
+    return (dev.bond_key.key_mask & ESP_BLE_ID_KEY_MASK) &&
+           memcmp(dev.bond_key.pid_key.static_addr, identity, 6) == 0;
+}
+
+// Remove one device by identity address (or the address it bonded under):
+// its bond, its index record and its published IRK
+static void remove_bonded_device(const uint8_t* identity) {
+    irkstore::Record record;
+    bool indexed = irk_index_find(identity, &record);
+
+    int dev_num = esp_ble_get_bond_device_num();
+    if (dev_num > 0) {
+        esp_ble_bond_dev_t *dev_list = (esp_ble_bond_dev_t *)malloc(sizeof(esp_ble_bond_dev_t) * dev_num);
+        esp_ble_get_bond_device_list(&dev_num, dev_list);
+        for (int i = 0; i < dev_num; i++) {
+            if (!bond_matches(dev_list[i], identity)) continue;
+
+            esp_ble_remove_bond_device(dev_list[i].bd_addr);
+            serial_link_send_bond_removed(dev_list[i].bd_addr);
+            if (!indexed && (dev_list[i].bond_key.key_mask & ESP_BLE_ID_KEY_MASK)) {
+                memcpy(record.irk, dev_list[i].bond_key.pid_key.irk, 16);
+                indexed = true;
+            }
+        }
+        free(dev_list);
+    }
+
+    irk_index_remove(identity);
+    if (indexed) irk_publish_forget(record.irk);
+    // Don't wait for the bond count change to reload the resolver's IRKs
+    rpa_service_invalidate();
+
+    char mac[rpa::ADDRESS_STR_LEN + 1];
+    rpa::formatAddress(identity, mac);
+    if (connectedDeviceMAC == mac) clear_current_irk();
+    ESP_LOGI(GATTS_TABLE_TAG, "Removed device %s", mac);
 }
+#endif
 
 // GAP event handler
-static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param) {
+static void handle_gap_event(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param) {
     ESP_LOGV(GATTS_TABLE_TAG, "GAP_EVT, event:%d", event);
 
     switch (event) {
@@ -980,8 +1317,15 @@ static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param
             if (param->adv_start_cmpl.status != ESP_BT_STATUS_SUCCESS) {
                 ESP_LOGE(GATTS_TABLE_TAG, "Advertising start failed");
             } else {
-                ESP_LOGI(GATTS_TABLE_TAG, "Advertising started - Device name: ESP32_IRK_FINDER");
-                Serial.println("BLE advertising started - look for 'ESP32_IRK_FINDER'");
+                ESP_LOGI(GATTS_TABLE_TAG, "Advertising started - Device name: %s", APP_CONFIG.ble.name);
+                Serial.printf("BLE advertising started - look for '%s'\n", APP_CONFIG.ble.name);
+                // Advertising restarts after every disconnect; only the
+                // first start measures boot
+                static bool bootReported = false;
+                if (!bootReported) {
+                    bootReported = true;
+                    Serial.printf("Boot to advertising: %lu ms\n", millis());
+                }
             }
             break;
 
@@ -996,13 +1340,21 @@ static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param
             break;
 
         case ESP_GAP_BLE_SEC_REQ_EVT:
+            pairing_stats_request();
             esp_ble_gap_security_rsp(param->ble_security.ble_req.bd_addr, true);
             break;
 
         case ESP_GAP_BLE_AUTH_CMPL_EVT:
+#if !HEADLESS_MODE
+            http_admission_set_pairing(false);
+#endif
+            pairing_stats_complete(param->ble_security.auth_cmpl.success);
+            coex_policy_pairing_finished();
             if(param->ble_security.auth_cmpl.success) {
                 ESP_LOGI(GATTS_TABLE_TAG, "Authentication success!");
                 Serial.println("Authentication completed successfully!");
+                rpa_service_invalidate();
+                conn_params_on_paired(param->ble_security.auth_cmpl.bd_addr);
                 // Show bonded devices to extract IRK
                 show_bonded_devices();
             } else {
@@ -1015,40 +1367,33 @@ static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param
         case ESP_GAP_BLE_KEY_EVT:
             // Key exchange event - this is when we receive the IRK
             ESP_LOGI(GATTS_TABLE_TAG, "ESP_GAP_BLE_KEY_EVT, key type = %d", param->ble_security.ble_key.key_type);
+            pairing_stats_key();
 
             if (param->ble_security.ble_key.key_type == ESP_LE_KEY_PID) {
                 // We received the IRK (Identity Resolving Key)
                 ESP_LOGI(GATTS_TABLE_TAG, "Received IRK from peer device");
 
-                // Extract and display the IRK immediately
-                uint8_t* irk_bytes = param->ble_security.ble_key.p_key_value.pid_key.irk;
-                char irk_str[33];
-                for(int j = 0; j < 16; j++) {
-                    sprintf(&irk_str[j * 2], "%02x", irk_bytes[j]);
+                esp_ble_pid_keys_t* pid = &param->ble_security.ble_key.p_key_value.pid_key;
+
+                // Index on the identity address so a repeat pairing of the
+                // same phone updates its record instead of adding a new one
+                irkstore::Record known;
+                irkstore::UpsertResult indexed = irk_index_record(pid->static_addr, pid->addr_type, pid->irk, &known);
+                currentPairCount = indexed == irkstore::FULL ? 1 : known.pairCount;
+                if (indexed == irkstore::UPDATED) {
+                    Serial.printf("Known device - pairing #%u since boot\n", currentPairCount);
+                } else if (indexed == irkstore::FULL) {
+                    Serial.println("Device index full - not recorded");
                 }
-                irk_str[32] = '\0';
-
-                currentIRK = String(irk_str);
-                currentIRKBase64 = base64Encode(irk_bytes, 16);
-                currentIRKReversed = reverseIRK(irk_bytes);
-                currentIRKArray = formatIRKArray(irk_bytes);
-                irkRetrieved = true;
-
-                Serial.println("\n========================================");
-                Serial.println("IRK RECEIVED VIA KEY EXCHANGE!");
-                Serial.println("--- IRK Formats ---");
-                Serial.print("Standard Hex: ");
-                Serial.println(currentIRK);
-                Serial.print("ESPresense (reversed): ");
-                Serial.println(currentIRKReversed);
-                Serial.print("Base64 (HA Private BLE): ");
-                Serial.println(currentIRKBase64);
-                Serial.print("Hex Array: ");
-                Serial.println(currentIRKArray);
-                Serial.println("========================================\n");
+
+                irk_publish(param->ble_security.ble_key.bd_addr, pid->static_addr, pid->addr_type, pid->irk, true);
             }
             break;
 
+        case ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT:
+            conn_params_on_update(param->update_conn_params);
+            break;
+
         case ESP_GAP_BLE_SET_LOCAL_PRIVACY_COMPLETE_EVT: {
             if (param->local_privacy_cmpl.status != ESP_BT_STATUS_SUCCESS) {
                 ESP_LOGE(GATTS_TABLE_TAG, "config local privacy failed");
@@ -1082,16 +1427,23 @@ static void gatts_profile_event_handler(esp_gatts_cb_event_t event,
                                         esp_ble_gatts_cb_param_t *param) {
     switch (event) {
         case ESP_GATTS_REG_EVT:
-            esp_ble_gap_set_device_name(EXAMPLE_DEVICE_NAME);
+            esp_ble_gap_set_device_name(APP_CONFIG.ble.name);
             // Set random address for iOS compatibility
             esp_ble_gap_set_rand_addr(rand_addr);
             esp_ble_gap_config_local_privacy(true);
-            esp_ble_gatts_create_attr_tab(heart_rate_gatt_db, gatts_if, HRS_IDX_NB, HEART_RATE_SVC_INST_ID);
+            esp_ble_gatts_create_attr_tab(gatt_db, gatts_if, GATT_IDX_NB, HEART_RATE_SVC_INST_ID);
             break;
 
         case ESP_GATTS_CONNECT_EVT:
             ESP_LOGI(GATTS_TABLE_TAG, "Device connected");
             Serial.println("Device connected - starting security");
+#if !HEADLESS_MODE
+            http_admission_set_pairing(true);
+#endif
+            // Give BLE the radio until SMP finishes
+            coex_policy_pairing_started();
+            pairing_stats_connect(coex_policy_pairing(), conn_params_fast());
+            conn_params_on_connect(param->connect);
 
             // Start encryption with MITM protection immediately
             esp_ble_set_encryption(param->connect.remote_bda, ESP_BLE_SEC_ENCRYPT_MITM);
@@ -1100,14 +1452,19 @@ static void gatts_profile_event_handler(esp_gatts_cb_event_t event,
         case ESP_GATTS_DISCONNECT_EVT:
             ESP_LOGI(GATTS_TABLE_TAG, "Device disconnected");
             Serial.println("Device disconnected");
+#if !HEADLESS_MODE
+            http_admission_set_pairing(false);
+#endif
+            pairing_stats_disconnect();
+            coex_policy_pairing_finished();
             esp_ble_gap_start_advertising(&heart_rate_adv_params);
             break;
 
         case ESP_GATTS_CREAT_ATTR_TAB_EVT:
             if (param->add_attr_tab.status == ESP_GATT_OK) {
-                if(param->add_attr_tab.num_handle == HRS_IDX_NB) {
-                    memcpy(heart_rate_handle_table, param->add_attr_tab.handles, sizeof(heart_rate_handle_table));
-                    esp_ble_gatts_start_service(heart_rate_handle_table[HRS_IDX_SVC]);
+                if(param->add_attr_tab.num_handle == GATT_IDX_NB) {
+                    memcpy(gatt_handle_table, param->add_attr_tab.handles, sizeof(gatt_handle_table));
+                    esp_ble_gatts_start_service(gatt_handle_table[GATT_IDX_SVC]);
                 }
             }
             break;
@@ -1117,9 +1474,9 @@ static void gatts_profile_event_handler(esp_gatts_cb_event_t event,
     }
 }
 
-// Main GATTS event handler
-static void gatts_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if,
-                                esp_ble_gatts_cb_param_t *param) {
+// Route GATTS events to the profile they belong to
+static void dispatch_gatts_event(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if,
+                                 esp_ble_gatts_cb_param_t *param) {
     if (event == ESP_GATTS_REG_EVT) {
         if (param->reg.status == ESP_GATT_OK) {
             heart_rate_profile_tab[HEART_PROFILE_APP_IDX].gatts_if = gatts_if;
@@ -1137,6 +1494,69 @@ static void gatts_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_
     }
 }
 
+// Callbacks registered with Bluedroid: trace and time every event
+static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param) {
+    int64_t start = esp_timer_get_time();
+    event_trace_gap(event, param);
+    handle_gap_event(event, param);
+    task_monitor_bt_callback(TRACE_GAP, (uint8_t)event, (uint32_t)(esp_timer_get_time() - start));
+}
+
+static void gatts_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if,
+                                esp_ble_gatts_cb_param_t *param) {
+    int64_t start = esp_timer_get_time();
+    event_trace_gatts(event, param);
+    dispatch_gatts_event(event, gatts_if, param);
+    task_monitor_bt_callback(TRACE_GATTS, (uint8_t)event, (uint32_t)(esp_timer_get_time() - start));
+}
+
+// Handle a command frame from the serial host
+static void handle_serial_command(uint8_t type, const uint8_t* payload, size_t len) {
+    (void)payload;
+    (void)len;
+
+    switch (type) {
+        case irkframe::CMD_RESET:
+            remove_all_bonded_devices();
+            Serial.println("IRK reset requested via serial link");
+            serial_link_send_ack(type, 0);
+            break;
+
+        case irkframe::CMD_LIST:
+        case irkframe::CMD_EXPORT: {
+            // Only bonds with an identity key, under their identity address,
+            // as EVT_IRK_CAPTURED reports them
+            int dev_num = esp_ble_get_bond_device_num();
+            uint8_t sent = 0;
+            if (dev_num > 0) {
+                esp_ble_bond_dev_t *dev_list = (esp_ble_bond_dev_t *)malloc(sizeof(esp_ble_bond_dev_t) * dev_num);
+                esp_ble_get_bond_device_list(&dev_num, dev_list);
+                for (int i = 0; i < dev_num; i++) {
+                    if (!(dev_list[i].bond_key.key_mask & ESP_BLE_ID_KEY_MASK)) continue;
+                    const esp_ble_pid_keys_t& pid = dev_list[i].bond_key.pid_key;
+                    if (type == irkframe::CMD_LIST) {
+                        serial_link_send_bond_entry(pid.static_addr, pid.addr_type);
+                    } else {
+                        serial_link_send_irk(pid.static_addr, pid.addr_type, pid.irk);
+                    }
+                    sent++;
+                }
+                free(dev_list);
+            }
+            serial_link_send_list_end(sent);
+            break;
+        }
+
+        case irkframe::CMD_STATUS:
+            serial_link_send_status((uint8_t)esp_ble_get_bond_device_num(), irkRetrieved);
+            break;
+
+        default:
+            serial_link_send_ack(type, 1);
+            break;
+    }
+}
+
 // Initialize Bluetooth
 void BT_Init() {
     ESP_LOGI(GATTS_TABLE_TAG, "Initializing Bluetooth...");
@@ -1149,7 +1569,30 @@ void BT_Init() {
     }
     ESP_ERROR_CHECK(ret);
 
-    // Start Bluetooth
+    uint32_t heapBeforeBT = ESP.getFreeHeap();
+
+#if BT_BLE_ONLY
+    // Hand the BR/EDR controller memory back to the heap. This must happen
+    // before the controller is initialized and cannot be undone.
+    esp_bt_controller_mem_release(ESP_BT_MODE_CLASSIC_BT);
+
+    esp_bt_controller_config_t bt_cfg = BT_CONTROLLER_INIT_CONFIG_DEFAULT();
+#if CONFIG_IDF_TARGET_ESP32
+    bt_cfg.mode = ESP_BT_MODE_BLE;
+    bt_cfg.ble_max_conn = BT_BLE_MAX_CONN;
+#else
+    bt_cfg.ble_max_act = BT_BLE_MAX_CONN + 1;  // advertising set + link
+#endif
+
+    if (esp_bt_controller_get_status() == ESP_BT_CONTROLLER_STATUS_IDLE) {
+        ESP_ERROR_CHECK(esp_bt_controller_init(&bt_cfg));
+    }
+    if (esp_bt_controller_get_status() == ESP_BT_CONTROLLER_STATUS_INITED) {
+        ESP_ERROR_CHECK(esp_bt_controller_enable(ESP_BT_MODE_BLE));
+    }
+#endif
+
+    // Start Bluetooth (no-op if the controller is already enabled above)
     btStart();
 
     // Initialize Bluedroid
@@ -1173,7 +1616,7 @@ void BT_Init() {
     uint8_t key_size = 16;
     uint8_t init_key = ESP_BLE_ENC_KEY_MASK | ESP_BLE_ID_KEY_MASK;
     uint8_t rsp_key = ESP_BLE_ENC_KEY_MASK | ESP_BLE_ID_KEY_MASK;
-    uint32_t passkey = 123456;
+    uint32_t passkey = APP_CONFIG.ble.passkey;
     uint8_t auth_option = ESP_BLE_ONLY_ACCEPT_SPECIFIED_AUTH_DISABLE;
 
     esp_ble_gap_set_security_param(ESP_BLE_SM_SET_STATIC_PASSKEY, &passkey, sizeof(uint32_t));
@@ -1184,17 +1627,73 @@ void BT_Init() {
     esp_ble_gap_set_security_param(ESP_BLE_SM_SET_INIT_KEY, &init_key, sizeof(uint8_t));
     esp_ble_gap_set_security_param(ESP_BLE_SM_SET_RSP_KEY, &rsp_key, sizeof(uint8_t));
 
-    Serial.println("Bluetooth initialized - Passkey: 123456");
+    Serial.printf("Bluetooth initialized - Passkey: %06lu\n", (unsigned long)passkey);
+    Serial.printf("Free heap: %u bytes (BT stack took %d bytes, BLE-only: %s)\n",
+                  ESP.getFreeHeap(), (int)(heapBeforeBT - ESP.getFreeHeap()),
+                  BT_BLE_ONLY ? "yes" : "no");
+}
+
+#if !HEADLESS_MODE
+#if MDNS_ENABLED
+// Announce <hostname>.local and the web server
+static void startMDNS() {
+    if (MDNS.begin(APP_CONFIG.net.hostname)) {
+        MDNS.addService("http", "tcp", APP_CONFIG.net.webPort);
+        Serial.println("mDNS responder started");
+    } else {
+        Serial.println("Error starting mDNS");
+    }
+}
+#endif
+
+#if AP_MODE_ENABLED
+// Configuration access point, with the captive portal DNS if enabled
+static void startAPMode() {
+    Serial.println("Starting AP mode for configuration...");
+    WiFi.mode(WIFI_AP);
+    WiFi.softAP(APP_CONFIG.net.apSsid, APP_CONFIG.net.apPassword);
+    isAPMode = true;
+
+#if MDNS_ENABLED
+    // Start mDNS even in AP mode
+    startMDNS();
+#endif
+
+#if CAPTIVE_DNS_ENABLED
+    // Start DNS server for captive portal
+    dnsServer.start(DNS_PORT, "*", WiFi.softAPIP());
+    xTaskCreateUniversal(dnsTask, "dns", 3072, NULL, TASK_PRIO_DNS, NULL, TASK_CORE_DNS);
+#endif
+
+    Serial.println("\n========================================");
+    Serial.println("Access Point Started!");
+    Serial.print("WiFi SSID: ");
+    Serial.println(APP_CONFIG.net.apSsid);
+    Serial.print("WiFi Password: ");
+    Serial.println(APP_CONFIG.net.apPassword);
+    Serial.println("\nAccess the device at:");
+    if (APP_CONFIG.features.mdns) {
+        Serial.printf("  - http://%s.local\n", APP_CONFIG.net.hostname);
+    }
+    Serial.print("  - http://");
+    Serial.println(WiFi.softAPIP());
+    if (APP_CONFIG.features.captiveDns) {
+        Serial.println("\nConnect to WiFi and you'll be redirected to config");
+    }
+    Serial.println("========================================\n");
 }
+#endif
 
 // Setup WiFi with saved credentials or AP mode
 void setupWiFi() {
     // Check if we should force AP mode from .env configuration
-    #if USE_AP_MODE == 1
+#if AP_MODE_ENABLED
+    if (APP_CONFIG.features.forceApMode) {
         Serial.println("AP mode forced by configuration (USE_AP_MODE=true in .env)");
         startAPMode();
         return;
-    #endif
+    }
+#endif
 
     // First, check if we have valid credentials from .env
     String envSSID = WIFI_SSID;
@@ -1274,74 +1773,387 @@ void setupWiFi() {
             Serial.println("\n========================================");
             Serial.println("WiFi connected successfully!");
             Serial.println("Access the device at:");
-            Serial.print("  - http://");
-            Serial.print(mdnsHostname);
-            Serial.println(".local");
+            if (APP_CONFIG.features.mdns) {
+                Serial.printf("  - http://%s.local\n", APP_CONFIG.net.hostname);
+            }
             Serial.print("  - http://");
             Serial.println(WiFi.localIP());
             Serial.println("========================================");
 
-            // Start mDNS
-            if (MDNS.begin(mdnsHostname)) {
-                MDNS.addService("http", "tcp", 80);
-                Serial.println("mDNS responder started");
-            } else {
-                Serial.println("Error starting mDNS");
-            }
-
-            isAPMode = false;
+#if MDNS_ENABLED
+            startMDNS();
+#endif
             return;
         } else {
             Serial.println("\nFailed to connect with saved credentials.");
         }
     }
 
+#if AP_MODE_ENABLED
     // Start AP mode if no credentials or connection failed
-    Serial.println("Starting AP mode for configuration...");
-    WiFi.mode(WIFI_AP);
-    WiFi.softAP(AP_SSID, AP_PASSWORD);
-    isAPMode = true;
+    startAPMode();
+#else
+    // No AP to fall back to; the WiFi driver keeps retrying the station
+    if (stored_ssid.length() == 0) {
+        Serial.println("No WiFi credentials and AP mode is disabled (AP_MODE_ENABLED=0), set WIFI_SSID in .env");
+    } else {
+        Serial.println("WiFi not connected yet, retrying in the background (AP mode disabled)");
+    }
+#endif
+}
 
-    // Start mDNS even in AP mode
-    if (MDNS.begin(mdnsHostname)) {
-        Serial.print("mDNS responder started. Access at: http://");
-        Serial.print(mdnsHostname);
-        Serial.println(".local");
-        MDNS.addService("http", "tcp", 80);
+typedef JsonWriter<AsyncResponseStream> ResponseJson;
+
+// Upper bounds of the JSON responses, used to size their stream buffers once
+static constexpr size_t SUCCESS_JSON_MAX = jsonsize::braces() + jsonsize::key("success") + jsonsize::boolean();
+
+static constexpr size_t OTA_JSON_MAX = jsonsize::braces()
+    + jsonsize::key("success") + jsonsize::boolean()
+    + jsonsize::key("compressed") + jsonsize::boolean()
+    + jsonsize::key("received") + jsonsize::u32()
+    + jsonsize::key("written") + jsonsize::u32()
+    + jsonsize::key("elapsedMs") + jsonsize::u32()
+    + jsonsize::key("minFreeHeap") + jsonsize::u32();
+
+static constexpr size_t STATUS_JSON_MAX = jsonsize::braces()
+    + jsonsize::key("irk") + jsonsize::plain(32)
+    + jsonsize::key("irkReversed") + jsonsize::plain(32)
+    + jsonsize::key("irkBase64") + jsonsize::plain(24)
+    + jsonsize::key("irkArray") + jsonsize::plain(16 * 5)
+    + jsonsize::key("mac") + jsonsize::plain(17)
+    + jsonsize::key("irkRetrieved") + jsonsize::boolean()
+    + jsonsize::key("pairCount") + jsonsize::u32()
+    + jsonsize::key("knownDevices") + jsonsize::u32()
+    + jsonsize::key("isAPMode") + jsonsize::boolean()
+    + jsonsize::key("ipAddress") + jsonsize::ipv4();
+
+static constexpr size_t WIFI_STATUS_JSON_MAX = jsonsize::braces()
+    + jsonsize::key("connected") + jsonsize::boolean()
+    + jsonsize::key("ssid") + jsonsize::str(32)
+    + jsonsize::key("ip") + jsonsize::ipv4()
+    + jsonsize::key("mode") + jsonsize::plain(7);
+
+static constexpr size_t DEBUG_HEAP_JSON_MAX = jsonsize::braces() * 2
+    + jsonsize::key("freeHeap") + jsonsize::u32()
+    + jsonsize::key("minFreeHeap") + jsonsize::u32()
+    + jsonsize::key("maxAllocHeap") + jsonsize::u32()
+    + jsonsize::key("uptimeMs") + jsonsize::u32()
+    + jsonsize::key("http")
+    + jsonsize::key("admitted") + jsonsize::u32()
+    + jsonsize::key("rejectedBusy") + jsonsize::u32()
+    + jsonsize::key("rejectedRate") + jsonsize::u32()
+    + jsonsize::key("rejectedPairing") + jsonsize::u32()
+    + jsonsize::key("expired") + jsonsize::u32()
+    + jsonsize::key("inFlight") + jsonsize::i32()
+    + jsonsize::key("irk") + jsonsize::braces()
+    + jsonsize::key("captures") + jsonsize::u32()
+    + jsonsize::key("duplicates") + jsonsize::u32()
+    + jsonsize::key("formatted") + jsonsize::u32()
+    + jsonsize::key("published") + jsonsize::u32();
+
+static constexpr size_t WIFI_SCAN_JSON_MAX = jsonsize::braces()
+    + jsonsize::key("scanning") + jsonsize::boolean()
+    + jsonsize::key("ageMs") + jsonsize::u32()
+    + jsonsize::key("networks") + jsonsize::braces()
+    + WIFI_SCAN_MAX_RESULTS * (jsonsize::braces() + 1
+        + jsonsize::key("ssid") + jsonsize::str(32)
+        + jsonsize::key("rssi") + jsonsize::i32()
+        + jsonsize::key("channel") + jsonsize::u32()
+        + jsonsize::key("secure") + jsonsize::boolean());
+
+static constexpr size_t PAIRING_POLICY_JSON_MAX = jsonsize::braces()
+    + jsonsize::key("attempts") + jsonsize::u32()
+    + jsonsize::key("successes") + jsonsize::u32()
+    + jsonsize::key("failures") + jsonsize::u32()
+    + jsonsize::key("avgMs") + jsonsize::u32()
+    + jsonsize::key("minMs") + jsonsize::u32()
+    + jsonsize::key("maxMs") + jsonsize::u32()
+    + jsonsize::key("lastMs") + jsonsize::u32();
+
+static constexpr size_t KEY_LATENCY_JSON_MAX = jsonsize::braces()
+    + jsonsize::key("samples") + jsonsize::u32()
+    + jsonsize::key("avgMs") + jsonsize::u32()
+    + jsonsize::key("minMs") + jsonsize::u32()
+    + jsonsize::key("maxMs") + jsonsize::u32()
+    + jsonsize::key("lastMs") + jsonsize::u32();
+
+static constexpr size_t STAGE_JSON_MAX = jsonsize::braces()
+    + jsonsize::key("avgMs") + jsonsize::u32()
+    + jsonsize::key("maxMs") + jsonsize::u32()
+    + jsonsize::key("lastMs") + jsonsize::u32();
+
+static constexpr size_t ECC_PATH_JSON_MAX = jsonsize::braces()
+    + jsonsize::key("valid") + jsonsize::boolean()
+    + jsonsize::key("keyPairUs") + jsonsize::u32()
+    + jsonsize::key("dhKeyUs") + jsonsize::u32();
+
+static constexpr size_t PAIRING_STATS_JSON_MAX = jsonsize::braces() * 5
+    + jsonsize::key("active") + jsonsize::boolean()
+    + jsonsize::key("gattDb") + jsonsize::plain(10)
+    + jsonsize::key("fastConnParams") + jsonsize::boolean()
+    + jsonsize::key("keyLatency")
+    + jsonsize::key("fastConn") + KEY_LATENCY_JSON_MAX
+    + jsonsize::key("defaultConn") + KEY_LATENCY_JSON_MAX
+    + jsonsize::key("pairingPolicy") + jsonsize::plain(7)
+    + jsonsize::key("idlePolicy") + jsonsize::plain(7)
+    + jsonsize::key("policies")
+    + PAIRING_POLICY_COUNT * (jsonsize::key("balance") + PAIRING_POLICY_JSON_MAX)
+    + jsonsize::key("stages") + jsonsize::key("samples") + jsonsize::u32()
+    + PAIRING_STAGE_COUNT * (jsonsize::key("security") + STAGE_JSON_MAX)
+    + jsonsize::key("ecc") + jsonsize::key("measured") + jsonsize::boolean()
+    + jsonsize::key("mbedtls") + ECC_PATH_JSON_MAX;
+
+static constexpr size_t TASK_JSON_MAX = jsonsize::braces() + 1
+    + jsonsize::key("name") + jsonsize::str(TASK_NAME_LEN - 1)
+    + jsonsize::key("core") + jsonsize::i32()
+    + jsonsize::key("priority") + jsonsize::u32()
+    + jsonsize::key("cpuPermille") + jsonsize::u32()
+    + jsonsize::key("stackFree") + jsonsize::u32();
+
+static constexpr size_t BT_EVENT_JSON_MAX = jsonsize::braces()
+    + jsonsize::key("source") + jsonsize::plain(5)
+    + jsonsize::key("event") + jsonsize::plain(24)
+    + jsonsize::key("us") + jsonsize::u32();
+
+static constexpr size_t TASKS_JSON_MAX = jsonsize::braces() * 4
+    + jsonsize::key("runtimeStats") + jsonsize::boolean()
+    + jsonsize::key("sampling")
+    + jsonsize::key("samples") + jsonsize::u32()
+    + jsonsize::key("windowMs") + jsonsize::u32()
+    + jsonsize::key("lastUs") + jsonsize::u32()
+    + jsonsize::key("maxUs") + jsonsize::u32()
+    + jsonsize::key("overheadPpm") + jsonsize::u32()
+    + jsonsize::key("truncated") + jsonsize::u32()
+    + jsonsize::key("tasks")
+    + TASK_MONITOR_MAX_TASKS * TASK_JSON_MAX
+    + jsonsize::key("btCallbacks")
+    + jsonsize::key("budgetUs") + jsonsize::u32()
+    + jsonsize::key("calls") + jsonsize::u32()
+    + jsonsize::key("overruns") + jsonsize::u32()
+    + jsonsize::key("slowest") + BT_EVENT_JSON_MAX
+    + jsonsize::key("lastOverrun") + BT_EVENT_JSON_MAX + jsonsize::key("ageMs") + jsonsize::u32();
+
+static constexpr size_t LOGSHIP_JSON_MAX = jsonsize::braces()
+    + jsonsize::key("enabled") + jsonsize::boolean()
+    + jsonsize::key("connected") + jsonsize::boolean()
+    + jsonsize::key("benchRunning") + jsonsize::boolean()
+    + jsonsize::key("queued") + jsonsize::u32()
+    + jsonsize::key("dropped") + jsonsize::u32()
+    + jsonsize::key("sent") + jsonsize::u32()
+    + jsonsize::key("datagrams") + jsonsize::u32()
+    + jsonsize::key("sendErrors") + jsonsize::u32();
+
+// Log shipper bench limits for POST /api/debug/logship
+#define LOGSHIP_BENCH_MAX_RATE 20000
+#define LOGSHIP_BENCH_MAX_SECONDS 60
+
+// {"addresses":["AA:BB:CC:DD:EE:FF",...]} with some room for whitespace
+static constexpr size_t RESOLVE_BODY_MAX = 32 + RESOLVE_MAX_BATCH * (rpa::ADDRESS_STR_LEN + 8);
+
+static constexpr size_t RESOLVE_JSON_MAX = jsonsize::braces()
+    + jsonsize::key("irks") + jsonsize::u32()
+    + jsonsize::key("count") + jsonsize::u32()
+    + jsonsize::key("matched") + jsonsize::u32()
+    + jsonsize::key("elapsedUs") + jsonsize::u32()
+    + jsonsize::key("aes") + jsonsize::plain(8)
+    + jsonsize::key("results") + jsonsize::braces()
+    + RESOLVE_MAX_BATCH * rpa::resultJsonMax();
+
+static constexpr size_t DEVICE_JSON_MAX = jsonsize::braces() + 1
+    + jsonsize::key("address") + jsonsize::plain(rpa::ADDRESS_STR_LEN)
+    + jsonsize::key("addressType") + jsonsize::plain(6)
+    + jsonsize::key("irk") + jsonsize::plain(32)
+    + jsonsize::key("bonded") + jsonsize::boolean()
+    + jsonsize::key("pairCount") + jsonsize::u32()
+    + jsonsize::key("firstSeenMs") + jsonsize::u32()
+    + jsonsize::key("lastSeenMs") + jsonsize::u32();
+
+static constexpr size_t DEVICES_JSON_MAX = jsonsize::braces()
+    + jsonsize::key("total") + jsonsize::u32()
+    + jsonsize::key("count") + jsonsize::u32()
+    + jsonsize::key("next") + jsonsize::plain(rpa::ADDRESS_STR_LEN)
+    + jsonsize::key("devices") + jsonsize::braces()
+    + DEVICES_PAGE_MAX * DEVICE_JSON_MAX;
+
+static void writeKeyLatency(ResponseJson& json, const char* key, const PairingLatencyStats& s) {
+    json.key(key).beginObject();
+    json.field("samples", s.samples);
+    json.field("avgMs", s.samples ? s.totalMs / s.samples : 0);
+    json.field("minMs", s.minMs);
+    json.field("maxMs", s.maxMs);
+    json.field("lastMs", s.lastMs);
+    json.endObject();
+}
+
+static void writeEccPath(ResponseJson& json, const char* key, const ScEccPathStats& s) {
+    json.key(key).beginObject();
+    json.field("valid", s.valid);
+    json.field("keyPairUs", s.keyPairUs);
+    json.field("dhKeyUs", s.dhKeyUs);
+    json.endObject();
+}
+
+static void writeBtEvent(ResponseJson& json, uint8_t source, uint8_t event, uint32_t us) {
+    TraceEvent ev = {};
+    ev.source = source;
+    ev.event = event;
+    json.field("source", source == TRACE_GAP ? "gap" : "gatts");
+    json.field("event", event_trace_name(ev));
+    json.field("us", us);
+}
+
+static void writeIP(ResponseJson& json, const char* key, IPAddress ip) {
+    json.key(key).ipv4(ip[0], ip[1], ip[2], ip[3]);
+}
+
+static constexpr size_t ERROR_JSON_MAX = jsonsize::braces()
+    + jsonsize::key("success") + jsonsize::boolean()
+    + jsonsize::key("error") + jsonsize::plain(32);
+
+static void sendJsonSuccess(AsyncWebServerRequest *request) {
+    AsyncResponseStream *response = request->beginResponseStream("application/json", SUCCESS_JSON_MAX);
+    ResponseJson json(*response);
+    json.beginObject().field("success", true).endObject();
+    request->send(response);
+}
+
+static void sendJsonError(AsyncWebServerRequest *request, int code, const char* error) {
+    AsyncResponseStream *response = request->beginResponseStream("application/json", ERROR_JSON_MAX);
+    response->setCode(code);
+    ResponseJson json(*response);
+    json.beginObject().field("success", false).field("error", error).endObject();
+    request->send(response);
+}
+
+// Bodies may arrive in several chunks; collect them into one bounded,
+// NUL-terminated buffer in _tempObject (freed with the request). Oversized
+// bodies are dropped and the handler finds no buffer.
+static ArBodyHandlerFunction collectBody(size_t maxLen) {
+    return [maxLen](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total){
+        if (total > maxLen) return;
+        if (index == 0 && !request->_tempObject) {
+            request->_tempObject = calloc(1, total + 1);
+        }
+        char* body = (char*)request->_tempObject;
+        if (body && index + len <= total) {
+            memcpy(body + index, data, len);
+        }
+    };
+}
+
+#if OTA_ENABLED
+// Upload state kept in _tempObject between the body chunks and the handler
+struct OtaUpload {
+    uint32_t session;
+    OtaResult result;
+};
+
+static int otaErrorStatus(const char* error) {
+    if (!strcmp(error, "unauthorized")) return 401;
+    if (!strcmp(error, "no_ota_token")) return 403;
+    if (!strcmp(error, "busy")) return 409;
+    if (!strcmp(error, "sha256_mismatch")) return 422;
+    if (!strcmp(error, "no_ota_partition")) return 501;
+    if (!strcmp(error, "pairing")) return 503;
+    if (!strcmp(error, "out_of_memory") || !strcmp(error, "flash_write_failed") ||
+        !strcmp(error, "update_begin_failed")) return 500;
+    return 400;
+}
+
+static void otaBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+    OtaUpload* upload = (OtaUpload*)request->_tempObject;
+    if (index == 0 && !upload) {
+        upload = (OtaUpload*)calloc(1, sizeof(OtaUpload));
+        if (!upload) return;
+        request->_tempObject = upload;
+
+        // The image hash comes from the uploader too, so only the token says
+        // who sent it; without one configured nobody may upload
+        if (strlen(OTA_TOKEN) == 0) {
+            upload->result.error = "no_ota_token";
+            return;
+        }
+        if (request->header("X-OTA-Token") != OTA_TOKEN) {
+            upload->result.error = "unauthorized";
+            return;
+        }
+        // Flash writes stall the BT host; never start one mid-pairing
+        if (http_admission_pairing_active()) {
+            upload->result.error = "pairing";
+            return;
+        }
+        upload->session = ota_update_begin(request->header("X-Firmware-SHA256").c_str(), &upload->result);
+        if (upload->session) {
+            uint32_t session = upload->session;
+            request->onDisconnect([session](){ ota_update_abort(session); });
+        }
+    }
+    if (upload && upload->session) {
+        ota_update_write(data, len);
     }
+}
+#endif
 
-    // Start DNS server for captive portal
-    dnsServer.start(DNS_PORT, "*", WiFi.softAPIP());
+// Jobs run on the deferred scheduler task, never on the AsyncTCP task
 
-    Serial.println("\n========================================");
-    Serial.println("Access Point Started!");
-    Serial.print("WiFi SSID: ");
-    Serial.println(AP_SSID);
-    Serial.print("WiFi Password: ");
-    Serial.println(AP_PASSWORD);
-    Serial.println("\nAccess the device at:");
-    Serial.print("  - http://");
-    Serial.print(mdnsHostname);
-    Serial.println(".local");
-    Serial.print("  - http://");
-    Serial.println(WiFi.softAPIP());
-    Serial.println("\nConnect to WiFi and you'll be redirected to config");
-    Serial.println("========================================\n");
+struct WiFiCredentials {
+    char ssid[33];
+    char password[65];
+};
+
+static void job_restart(void* arg) {
+    ESP.restart();
+}
+
+static void job_save_wifi(void* arg) {
+    WiFiCredentials* creds = (WiFiCredentials*)arg;
+    preferences.begin("wifi", false);
+    preferences.putString("ssid", creds->ssid);
+    preferences.putString("password", creds->password);
+    preferences.end();
+    free(creds);
+}
+
+static void job_clear_wifi(void* arg) {
+    preferences.begin("wifi", false);
+    preferences.clear();
+    preferences.end();
+}
+
+static void job_remove_bonds(void* arg) {
+    remove_all_bonded_devices();
+}
+
+static void job_remove_device(void* arg) {
+    remove_bonded_device((const uint8_t*)arg);
+    free(arg);
+}
+
+// Parse an optional address query parameter; false only if present and
+// malformed
+static bool addressParam(AsyncWebServerRequest *request, const char* name, uint8_t* addr, bool* present) {
+    *present = false;
+    if (!request->hasParam(name)) return true;
+    const String& value = request->getParam(name)->value();
+    if (value.length() == 0) return true;
+    *present = true;
+    return rpa::parseAddress(value.c_str(), value.length(), addr);
 }
 
 // Setup web server
 void setupWebServer() {
-    server.on("/", HTTP_GET, [](AsyncWebServerRequest *request){
+#if WEB_UI_ENABLED
+    server.on("/", HTTP_GET, admitted([](AsyncWebServerRequest *request){
         // If in AP mode, always redirect to WiFi config
         if (isAPMode) {
             request->redirect("/wifi");
         } else {
             request->send_P(200, "text/html", index_html);
         }
-    });
+    }));
 
     // Serve favicon - CPU icon from Lucide with light/dark mode support
-    server.on("/favicon.svg", HTTP_GET, [](AsyncWebServerRequest *request){
+    server.on("/favicon.svg", HTTP_GET, admitted([](AsyncWebServerRequest *request){
         const char* favicon = R"rawliteral(
 <svg xmlns="http://www.w3.org/2000/svg" width="24" height="24" viewBox="0 0 24 24" fill="none">
   <style>
@@ -1372,107 +2184,598 @@ void setupWebServer() {
   <rect x="8" y="8" width="8" height="8" rx="1"/>
 </svg>)rawliteral";
         request->send(200, "image/svg+xml", favicon);
-    });
-
-    server.on("/api/status", HTTP_GET, [](AsyncWebServerRequest *request){
-        String json = "{";
-        json += "\"irk\":\"" + currentIRK + "\",";
-        json += "\"irkReversed\":\"" + currentIRKReversed + "\",";
-        json += "\"irkBase64\":\"" + currentIRKBase64 + "\",";
-        json += "\"irkArray\":\"" + currentIRKArray + "\",";
-        json += "\"mac\":\"" + connectedDeviceMAC + "\",";
-        json += "\"irkRetrieved\":" + String(irkRetrieved ? "true" : "false") + ",";
-        json += "\"isAPMode\":" + String(isAPMode ? "true" : "false") + ",";
-        json += "\"ipAddress\":\"" + (isAPMode ? WiFi.softAPIP().toString() : WiFi.localIP().toString()) + "\"";
-        json += "}";
-        request->send(200, "application/json", json);
-    });
+    }));
 
     // WiFi Configuration page
-    server.on("/wifi", HTTP_GET, [](AsyncWebServerRequest *request){
+    server.on("/wifi", HTTP_GET, admitted([](AsyncWebServerRequest *request){
         request->send_P(200, "text/html", wifi_html);
-    });
+    }));
+#endif
+
+    server.on("/api/status", HTTP_GET, admitted([](AsyncWebServerRequest *request){
+        AsyncResponseStream *response = request->beginResponseStream("application/json", STATUS_JSON_MAX);
+        ResponseJson json(*response);
+        json.beginObject();
+        json.key("irk").value(currentIRK.c_str(), currentIRK.length());
+        json.key("irkReversed").value(currentIRKReversed.c_str(), currentIRKReversed.length());
+        json.key("irkBase64").value(currentIRKBase64.c_str(), currentIRKBase64.length());
+        json.key("irkArray").value(currentIRKArray.c_str(), currentIRKArray.length());
+        json.key("mac").value(connectedDeviceMAC.c_str(), connectedDeviceMAC.length());
+        json.field("irkRetrieved", irkRetrieved);
+        json.field("pairCount", currentPairCount);
+        json.field("knownDevices", irk_index_count());
+        json.field("isAPMode", isAPMode);
+        writeIP(json, "ipAddress", isAPMode ? WiFi.softAPIP() : WiFi.localIP());
+        json.endObject();
+        request->send(response);
+    }));
 
     // Save WiFi credentials
-    server.on("/api/wifi/save", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL,
-        [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total){
-            DynamicJsonDocument doc(256);
-            deserializeJson(doc, (char*)data);
+    server.on("/api/wifi/save", HTTP_POST, admitted([](AsyncWebServerRequest *request){
+        // The body callback below has assembled the complete body by now
+        char* body = (char*)request->_tempObject;
+        if (!body) {
+            sendJsonError(request, request->contentLength() > WIFI_SAVE_BODY_MAX ? 413 : 400, "invalid_body");
+            return;
+        }
 
-            String ssid = doc["ssid"].as<String>();
-            String password = doc["password"].as<String>();
+        StaticJsonDocument<256> doc;
+        if (deserializeJson(doc, body, request->contentLength()) != DeserializationError::Ok) {
+            sendJsonError(request, 400, "invalid_json");
+            return;
+        }
 
-            preferences.begin("wifi", false);
-            preferences.putString("ssid", ssid);
-            preferences.putString("password", password);
-            preferences.end();
+        const char* ssid = doc["ssid"] | "";
+        const char* password = doc["password"] | "";
+        if (strlen(ssid) == 0 || strlen(ssid) > 32 || strlen(password) > 64) {
+            sendJsonError(request, 400, "invalid_credentials");
+            return;
+        }
 
-            String response = "{\"success\":true}";
-            request->send(200, "application/json", response);
+        WiFiCredentials* creds = (WiFiCredentials*)malloc(sizeof(WiFiCredentials));
+        if (!creds) {
+            sendJsonError(request, 500, "out_of_memory");
+            return;
+        }
+        strlcpy(creds->ssid, ssid, sizeof(creds->ssid));
+        strlcpy(creds->password, password, sizeof(creds->password));
 
-            delay(1000);
-            ESP.restart();
-        });
+        if (!deferred_post(job_save_wifi, creds, 0)) {
+            free(creds);
+            sendJsonError(request, 503, "busy");
+            return;
+        }
+        // The change is stored either way and applies on the next restart
+        if (!deferred_post(job_restart, NULL, RESTART_DELAY_MS)) {
+            Serial.println("WiFi settings changed but the restart could not be scheduled");
+            sendJsonError(request, 503, "busy");
+            return;
+        }
+        sendJsonSuccess(request);
+    }), NULL, collectBody(WIFI_SAVE_BODY_MAX));
 
     // Clear WiFi credentials
-    server.on("/api/wifi/clear", HTTP_POST, [](AsyncWebServerRequest *request){
-        preferences.begin("wifi", false);
-        preferences.clear();
-        preferences.end();
-
-        String response = "{\"success\":true}";
-        request->send(200, "application/json", response);
-
-        delay(1000);
-        ESP.restart();
-    });
+    server.on("/api/wifi/clear", HTTP_POST, admitted([](AsyncWebServerRequest *request){
+        if (!deferred_post(job_clear_wifi, NULL, 0)) {
+            sendJsonError(request, 503, "busy");
+            return;
+        }
+        // The change is stored either way and applies on the next restart
+        if (!deferred_post(job_restart, NULL, RESTART_DELAY_MS)) {
+            Serial.println("WiFi settings changed but the restart could not be scheduled");
+            sendJsonError(request, 503, "busy");
+            return;
+        }
+        sendJsonSuccess(request);
+    }));
+
+    // Nearby networks from the cached background scan
+    server.on("/api/wifi/scan", HTTP_GET, admitted([](AsyncWebServerRequest *request){
+        WiFiScanSnapshot scan = wifi_scan_refresh();
+
+        AsyncResponseStream *response = request->beginResponseStream("application/json", WIFI_SCAN_JSON_MAX);
+        ResponseJson json(*response);
+        json.beginObject();
+        json.field("scanning", scan.scanning);
+        json.field("ageMs", scan.ageMs);
+        json.key("networks").beginArray();
+        for (size_t i = 0; i < scan.count; i++) {
+            const WiFiScanNetwork& net = scan.networks[i];
+            json.beginObject();
+            json.field("ssid", net.ssid);
+            json.field("rssi", net.rssi);
+            json.field("channel", net.channel);
+            json.field("secure", net.secure);
+            json.endObject();
+        }
+        json.endArray();
+        json.endObject();
+        request->send(response);
+    }));
 
     // WiFi status
-    server.on("/api/wifi/status", HTTP_GET, [](AsyncWebServerRequest *request){
-        String json = "{";
-        json += "\"connected\":" + String(WiFi.status() == WL_CONNECTED ? "true" : "false") + ",";
-        json += "\"ssid\":\"" + (WiFi.status() == WL_CONNECTED ? WiFi.SSID() : "") + "\",";
-        json += "\"ip\":\"" + (isAPMode ? WiFi.softAPIP().toString() : WiFi.localIP().toString()) + "\",";
-        json += "\"mode\":\"" + String(isAPMode ? "AP" : "Station") + "\"";
-        json += "}";
-        request->send(200, "application/json", json);
-    });
+    server.on("/api/wifi/status", HTTP_GET, admitted([](AsyncWebServerRequest *request){
+        bool connected = WiFi.status() == WL_CONNECTED;
+
+        // Read the SSID straight from the driver config instead of a String copy
+        wifi_config_t conf = {};
+        size_t ssidLen = 0;
+        if (connected && esp_wifi_get_config(WIFI_IF_STA, &conf) == ESP_OK) {
+            ssidLen = strnlen((const char*)conf.sta.ssid, sizeof(conf.sta.ssid));
+        }
+
+        AsyncResponseStream *response = request->beginResponseStream("application/json", WIFI_STATUS_JSON_MAX);
+        ResponseJson json(*response);
+        json.beginObject();
+        json.field("connected", connected);
+        json.key("ssid").value((const char*)conf.sta.ssid, ssidLen);
+        writeIP(json, "ip", isAPMode ? WiFi.softAPIP() : WiFi.localIP());
+        json.field("mode", isAPMode ? "AP" : "Station");
+        json.endObject();
+        request->send(response);
+    }));
 
     // Reset IRK endpoint
-    server.on("/api/reset", HTTP_POST, [](AsyncWebServerRequest *request){
-        // Clear IRK data
-        currentIRK = "No IRK retrieved yet";
-        currentIRKBase64 = "";
-        currentIRKReversed = "";
-        currentIRKArray = "";
-        connectedDeviceMAC = "None";
-        irkRetrieved = false;
+    server.on("/api/reset", HTTP_POST, admitted([](AsyncWebServerRequest *request){
+        // Clear bonded devices off the AsyncTCP task
+        if (!deferred_post(job_remove_bonds, NULL, 0)) {
+            sendJsonError(request, 503, "busy");
+            return;
+        }
 
-        // Clear bonded devices
-        remove_all_bonded_devices();
+        // Clear IRK data
+        clear_current_irk();
 
         Serial.println("IRK reset requested via web interface");
 
-        String response = "{\"success\":true}";
-        request->send(200, "application/json", response);
+        sendJsonSuccess(request);
+    }));
+
+    // One page of known devices in identity address order. The cursor is
+    // the last address of the previous page, so pages stay bounded and
+    // consistent while devices pair or are removed in between.
+    server.on("/api/devices", HTTP_GET, admitted([](AsyncWebServerRequest *request){
+        uint8_t cursor[6];
+        bool hasCursor;
+        if (!addressParam(request, "cursor", cursor, &hasCursor)) {
+            sendJsonError(request, 400, "invalid_cursor");
+            return;
+        }
+        long limit = DEVICES_PAGE_MAX;
+        if (request->hasParam("limit")) {
+            limit = request->getParam("limit")->value().toInt();
+            if (limit < 1) {
+                sendJsonError(request, 400, "invalid_limit");
+                return;
+            }
+            if (limit > DEVICES_PAGE_MAX) limit = DEVICES_PAGE_MAX;
+        }
+        const char* query = request->hasParam("q") ? request->getParam("q")->value().c_str() : NULL;
+
+        irkstore::Record page[DEVICES_PAGE_MAX];
+        bool more = false;
+        uint16_t n = irk_index_page(hasCursor ? cursor : NULL, query, page, (uint16_t)limit, &more);
+
+        int bondNum = esp_ble_get_bond_device_num();
+        esp_ble_bond_dev_t *bonds = NULL;
+        if (bondNum > 0 && n > 0) {
+            bonds = (esp_ble_bond_dev_t *)malloc(sizeof(esp_ble_bond_dev_t) * bondNum);
+            if (bonds) esp_ble_get_bond_device_list(&bondNum, bonds);
+        }
+
+        AsyncResponseStream *response = request->beginResponseStream("application/json", DEVICES_JSON_MAX);
+        ResponseJson json(*response);
+        char addr[rpa::ADDRESS_STR_LEN + 1];
+        json.beginObject();
+        json.field("total", irk_index_count());
+        json.field("count", n);
+        json.key("next");
+        if (more) {
+            rpa::formatAddress(page[n - 1].addr, addr);
+            json.value(addr);
+        } else {
+            json.null();
+        }
+        json.key("devices").beginArray();
+        for (uint16_t i = 0; i < n; i++) {
+            bool bonded = false;
+            for (int b = 0; bonds && b < bondNum && !bonded; b++) {
+                bonded = bond_matches(bonds[b], page[i].addr);
+            }
+            rpa::formatAddress(page[i].addr, addr);
+            json.beginObject();
+            json.field("address", addr);
+            json.field("addressType", page[i].addrType ? "random" : "public");
+            json.key("irk").hex(page[i].irk, 16);
+            json.field("bonded", bonded);
+            json.field("pairCount", page[i].pairCount);
+            json.field("firstSeenMs", page[i].firstSeenMs);
+            json.field("lastSeenMs", page[i].lastSeenMs);
+            json.endObject();
+        }
+        json.endArray();
+        json.endObject();
+        free(bonds);
+        request->send(response);
+    }));
+
+    // Remove one device: its bond, its index record and, if it is the one
+    // shown, the current IRK
+    server.on("/api/devices", HTTP_DELETE, admitted([](AsyncWebServerRequest *request){
+        uint8_t identity[6];
+        bool present;
+        if (!addressParam(request, "address", identity, &present) || !present) {
+            sendJsonError(request, 400, "invalid_address");
+            return;
+        }
+
+        bool known = irk_index_find(identity, NULL);
+        int bondNum = esp_ble_get_bond_device_num();
+        if (!known && bondNum > 0) {
+            esp_ble_bond_dev_t *bonds = (esp_ble_bond_dev_t *)malloc(sizeof(esp_ble_bond_dev_t) * bondNum);
+            if (bonds) {
+                esp_ble_get_bond_device_list(&bondNum, bonds);
+                for (int b = 0; b < bondNum && !known; b++) known = bond_matches(bonds[b], identity);
+                free(bonds);
+            }
+        }
+        if (!known) {
+            sendJsonError(request, 404, "not_found");
+            return;
+        }
+
+        // Bond removal goes through the BT host; keep it off the AsyncTCP task
+        uint8_t* arg = (uint8_t*)malloc(6);
+        if (!arg) {
+            sendJsonError(request, 500, "out_of_memory");
+            return;
+        }
+        memcpy(arg, identity, 6);
+        if (!deferred_post(job_remove_device, arg, 0)) {
+            free(arg);
+            sendJsonError(request, 503, "busy");
+            return;
+        }
+        sendJsonSuccess(request);
+    }));
+
+#if OTA_ENABLED
+    // Firmware update: the image (plain or gzip) as the raw request body,
+    // SHA-256 of the uncompressed image in X-Firmware-SHA256. Not behind
+    // admission control, an upload takes far longer than any other request.
+    server.on("/api/ota", HTTP_POST, [](AsyncWebServerRequest *request){
+        OtaUpload* upload = (OtaUpload*)request->_tempObject;
+        if (!upload) {
+            sendJsonError(request, 400, "empty_body");
+            return;
+        }
+        if (upload->session) {
+            ota_update_finish(&upload->result);
+            upload->session = 0;
+        }
+        const OtaResult& r = upload->result;
+        if (r.error) {
+            sendJsonError(request, otaErrorStatus(r.error), r.error);
+            return;
+        }
+        // The new image only boots after the restart, so don't report
+        // success unless one is scheduled
+        if (!deferred_post(job_restart, NULL, RESTART_DELAY_MS)) {
+            Serial.println("Firmware update verified, but the restart could not be scheduled");
+            sendJsonError(request, 503, "restart_failed");
+            return;
+        }
+
+        AsyncResponseStream *response = request->beginResponseStream("application/json", OTA_JSON_MAX);
+        ResponseJson json(*response);
+        json.beginObject();
+        json.field("success", true);
+        json.field("compressed", r.compressed);
+        json.field("received", r.received);
+        json.field("written", r.written);
+        json.field("elapsedMs", r.elapsedMs);
+        json.field("minFreeHeap", r.minFreeHeap);
+        json.endObject();
+        request->send(response);
+
+        Serial.printf("Firmware update verified (%u bytes), restarting\n", r.written);
+    }, NULL, otaBody);
+#endif
+
+    // Resolve a batch of addresses against every bonded IRK
+    server.on("/api/resolve", HTTP_POST, admitted([](AsyncWebServerRequest *request){
+        char* body = (char*)request->_tempObject;
+        if (!body) {
+            sendJsonError(request, request->contentLength() > RESOLVE_BODY_MAX ? 413 : 400, "invalid_body");
+            return;
+        }
+
+        // One slot over the limit, so an oversized batch still parses and is
+        // told apart from malformed JSON. Strings stay in the body (zero-copy).
+        StaticJsonDocument<JSON_OBJECT_SIZE(1) + JSON_ARRAY_SIZE(RESOLVE_MAX_BATCH + 1)> doc;
+        DeserializationError err = deserializeJson(doc, body, request->contentLength());
+        if (err == DeserializationError::NoMemory) {
+            sendJsonError(request, 413, "too_many_addresses");
+            return;
+        }
+        if (err != DeserializationError::Ok) {
+            sendJsonError(request, 400, "invalid_json");
+            return;
+        }
+        JsonArrayConst list = doc["addresses"];
+        if (list.isNull() || list.size() == 0) {
+            sendJsonError(request, 400, "invalid_addresses");
+            return;
+        }
+        if (list.size() > RESOLVE_MAX_BATCH) {
+            sendJsonError(request, 413, "too_many_addresses");
+            return;
+        }
+
+        uint8_t addrs[RESOLVE_MAX_BATCH][6];
+        int results[RESOLVE_MAX_BATCH];
+        size_t n = 0;
+        for (JsonVariantConst v : list) {
+            const char* str = v.as<const char*>();
+            results[n] = (str && rpa::parseAddress(str, strlen(str), addrs[n])) ? 0 : rpa::INVALID_ADDRESS;
+            n++;
+        }
+
+        rpa::Identity identities[RESOLVE_MAX_IRKS];
+        RpaBatchStats stats = rpa_service_resolve(addrs, results, n, identities);
+
+        AsyncResponseStream *response = request->beginResponseStream("application/json", RESOLVE_JSON_MAX);
+        ResponseJson json(*response);
+        json.beginObject();
+        json.field("irks", stats.irks);
+        json.field("count", (uint32_t)n);
+        json.field("matched", (uint32_t)stats.matched);
+        json.field("elapsedUs", stats.elapsedUs);
+        json.field("aes", stats.hardwareAes ? "hardware" : "software");
+        json.key("results");
+        rpa::writeResults(json, addrs, results, n, identities);
+        json.endObject();
+        request->send(response);
+    }), NULL, collectBody(RESOLVE_BODY_MAX));
+
+    // Pairing duration and failures, per coexistence policy
+    server.on("/api/pairing/stats", HTTP_GET, admitted([](AsyncWebServerRequest *request){
+        AsyncResponseStream *response = request->beginResponseStream("application/json", PAIRING_STATS_JSON_MAX);
+        ResponseJson json(*response);
+        json.beginObject();
+        json.field("active", pairing_stats_active());
+        json.field("pairingPolicy", coex_policy_name(coex_policy_pairing()));
+        json.field("idlePolicy", coex_policy_name(coex_policy_idle()));
+        json.field("gattDb", GATT_DB_MINIMAL ? "minimal" : "heart_rate");
+        json.field("fastConnParams", conn_params_fast());
+        json.key("keyLatency").beginObject();
+        writeKeyLatency(json, "fastConn", pairing_stats_key_latency(true));
+        writeKeyLatency(json, "defaultConn", pairing_stats_key_latency(false));
+        json.endObject();
+        json.key("policies").beginObject();
+        for (uint8_t p = 0; p < PAIRING_POLICY_COUNT; p++) {
+            PairingPolicyStats s = pairing_stats_get(p);
+            json.key(coex_policy_name(p)).beginObject();
+            json.field("attempts", s.attempts);
+            json.field("successes", s.successes);
+            json.field("failures", s.failures);
+            json.field("avgMs", s.successes ? s.totalMs / s.successes : 0);
+            json.field("minMs", s.minMs);
+            json.field("maxMs", s.maxMs);
+            json.field("lastMs", s.lastMs);
+            json.endObject();
+        }
+        json.endObject();
+        PairingStageStats stages = pairing_stats_stages();
+        json.key("stages").beginObject();
+        json.field("samples", stages.samples);
+        for (uint8_t i = 0; i < PAIRING_STAGE_COUNT; i++) {
+            json.key(pairing_stage_name(i)).beginObject();
+            json.field("avgMs", stages.samples ? stages.totalMs[i] / stages.samples : 0);
+            json.field("maxMs", stages.maxMs[i]);
+            json.field("lastMs", stages.lastMs[i]);
+            json.endObject();
+        }
+        json.endObject();
+        ScEccStats ecc = sc_ecc_stats();
+        json.key("ecc").beginObject();
+        json.field("measured", ecc.done);
+        if (ecc.done) {
+            writeEccPath(json, "mbedtls", ecc.mbedtls);
+        }
+        json.endObject();
+        json.endObject();
+        request->send(response);
+    }));
+
+    // Toggle the fast connection-parameter request for A/B comparison
+    server.on("/api/pairing/conn", HTTP_POST, admitted([](AsyncWebServerRequest *request){
+        if (!request->hasParam("fast", true)) {
+            sendJsonError(request, 400, "missing_fast");
+            return;
+        }
+        conn_params_set_fast(request->getParam("fast", true)->value() == "1");
+        sendJsonSuccess(request);
+    }));
+
+    // Switch coexistence policies at runtime to compare them without reflashing
+    server.on("/api/coex", HTTP_POST, admitted([](AsyncWebServerRequest *request){
+        int pairing = coex_policy_pairing();
+        int idle = coex_policy_idle();
+        if (request->hasParam("pairing", true)) {
+            pairing = coex_policy_parse(request->getParam("pairing", true)->value().c_str());
+        }
+        if (request->hasParam("idle", true)) {
+            idle = coex_policy_parse(request->getParam("idle", true)->value().c_str());
+        }
+        if (pairing < 0 || idle < 0) {
+            sendJsonError(request, 400, "unknown_policy");
+            return;
+        }
+        coex_policy_set((uint8_t)pairing, (uint8_t)idle);
+        sendJsonSuccess(request);
+    }));
+
+#if HTTP_DEBUG_ENDPOINTS
+    // Heap and admission counters for load testing (tools/http-bench).
+    // Not admission-controlled so it can be sampled while the API is flooded.
+    server.on("/api/debug/heap", HTTP_GET, [](AsyncWebServerRequest *request){
+        HttpAdmissionStats adm = http_admission_stats();
+        IrkPublishStats pub = irk_publish_stats();
+        AsyncResponseStream *response = request->beginResponseStream("application/json", DEBUG_HEAP_JSON_MAX);
+        ResponseJson json(*response);
+        json.beginObject();
+        json.field("freeHeap", ESP.getFreeHeap());
+        json.field("minFreeHeap", ESP.getMinFreeHeap());
+        json.field("maxAllocHeap", ESP.getMaxAllocHeap());
+        json.field("uptimeMs", millis());
+        json.key("http").beginObject();
+        json.field("admitted", adm.admitted);
+        json.field("rejectedBusy", adm.rejectedBusy);
+        json.field("rejectedRate", adm.rejectedRate);
+        json.field("rejectedPairing", adm.rejectedPairing);
+        json.field("expired", adm.expired);
+        json.field("inFlight", adm.inFlight);
+        json.endObject();
+        json.key("irk").beginObject();
+        json.field("captures", pub.captures);
+        json.field("duplicates", pub.duplicates);
+        json.field("formatted", pub.formatted);
+        json.field("published", pub.published);
+        json.endObject();
+        json.endObject();
+        request->send(response);
+    });
+
+    // Per-task CPU share, stack and placement, and BT callback overruns.
+    // Not admission-controlled either: it is most useful under load.
+    server.on("/api/tasks", HTTP_GET, [](AsyncWebServerRequest *request){
+        static TaskInfo tasks[TASK_MONITOR_MAX_TASKS];
+        size_t count = task_monitor_tasks(tasks, TASK_MONITOR_MAX_TASKS);
+        TaskMonitorStats mon = task_monitor_stats();
+        BtCallbackStats bt = task_monitor_bt_stats();
+
+        AsyncResponseStream *response = request->beginResponseStream("application/json", TASKS_JSON_MAX);
+        ResponseJson json(*response);
+        json.beginObject();
+        json.field("runtimeStats", mon.runtimeStats);
+        json.key("sampling").beginObject();
+        json.field("samples", mon.samples);
+        json.field("windowMs", mon.windowMs);
+        json.field("lastUs", mon.lastSampleUs);
+        json.field("maxUs", mon.maxSampleUs);
+        json.field("overheadPpm", mon.overheadPpm);
+        json.field("truncated", mon.truncated);
+        json.endObject();
+        json.key("tasks").beginArray();
+        for (size_t i = 0; i < count; i++) {
+            json.beginObject();
+            json.field("name", tasks[i].name);
+            json.field("core", (int)tasks[i].core);
+            json.field("priority", (unsigned)tasks[i].priority);
+            json.field("cpuPermille", (unsigned)tasks[i].cpuPermille);
+            json.field("stackFree", tasks[i].stackFree);
+            json.endObject();
+        }
+        json.endArray();
+        json.key("btCallbacks").beginObject();
+        json.field("budgetUs", (unsigned)BT_CALLBACK_BUDGET_US);
+        json.field("calls", bt.calls);
+        json.field("overruns", bt.overruns);
+        if (bt.calls) {
+            json.key("slowest").beginObject();
+            writeBtEvent(json, bt.maxSource, bt.maxEvent, bt.maxUs);
+            json.endObject();
+        }
+        if (bt.overruns) {
+            json.key("lastOverrun").beginObject();
+            writeBtEvent(json, bt.lastOverrunSource, bt.lastOverrunEvent, bt.lastOverrunUs);
+            json.field("ageMs", millis() - bt.lastOverrunMs);
+            json.endObject();
+        }
+        json.endObject();
+        json.endObject();
+        request->send(response);
+    });
+
+    // Log shipper counters. Compare `sent` with what the collector received
+    // (tools/log-listen) for records lost on the network.
+    server.on("/api/debug/logship", HTTP_GET, [](AsyncWebServerRequest *request){
+        LogShipperStats ship = log_shipper_stats();
+        AsyncResponseStream *response = request->beginResponseStream("application/json", LOGSHIP_JSON_MAX);
+        ResponseJson json(*response);
+        json.beginObject();
+        json.field("enabled", (bool)LOG_SHIP_ENABLED);
+        json.field("connected", ship.connected);
+        json.field("benchRunning", ship.benchRunning);
+        json.field("queued", ship.queued);
+        json.field("dropped", ship.dropped);
+        json.field("sent", ship.sent);
+        json.field("datagrams", ship.datagrams);
+        json.field("sendErrors", ship.sendErrors);
+        json.endObject();
+        request->send(response);
     });
 
+    // Offer `rate` synthetic records per second for `seconds` to the shipper
+    server.on("/api/debug/logship", HTTP_POST, [](AsyncWebServerRequest *request){
+        long rate = request->hasParam("rate", true) ? request->getParam("rate", true)->value().toInt() : 0;
+        long seconds = request->hasParam("seconds", true) ? request->getParam("seconds", true)->value().toInt() : 0;
+        if (rate < 1 || rate > LOGSHIP_BENCH_MAX_RATE || seconds < 1 || seconds > LOGSHIP_BENCH_MAX_SECONDS) {
+            sendJsonError(request, 400, "invalid_bench");
+            return;
+        }
+        if (!LOG_SHIP_ENABLED) {
+            sendJsonError(request, 404, "log_ship_disabled");
+            return;
+        }
+        if (!log_shipper_bench((uint32_t)rate, (uint32_t)seconds)) {
+            sendJsonError(request, 409, "busy");
+            return;
+        }
+        sendJsonSuccess(request);
+    });
+
+#if TRACE_ENABLED
+    // Recent GAP/GATTS events as Chrome Trace Event JSON, streamed in chunks.
+    // The snapshot and the stream share one block in _tempObject, which the
+    // request frees when it is destroyed. Not admission-controlled, like the
+    // other diagnostics.
+    server.on("/api/trace", HTTP_GET, [](AsyncWebServerRequest *request){
+        uint8_t* block = (uint8_t*)malloc(sizeof(TraceJsonStream) + TRACE_RING_SIZE * sizeof(TraceEvent));
+        if (!block) {
+            sendJsonError(request, 503, "out_of_memory");
+            return;
+        }
+        TraceEvent* events = (TraceEvent*)(block + sizeof(TraceJsonStream));
+        size_t count = event_trace_snapshot(events, TRACE_RING_SIZE);
+        TraceJsonStream* stream = new (block) TraceJsonStream(events, count, event_trace_name, event_trace_spans());
+        request->_tempObject = block;
+        request->send(request->beginChunkedResponse("application/json",
+            [stream](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+                return stream->fill(buffer, maxLen);
+            }));
+    });
+#endif
+#endif
+
     // Captive portal handler - redirect all unknown URLs to WiFi config in AP mode
-    server.onNotFound([](AsyncWebServerRequest *request){
-        if (isAPMode) {
+    server.onNotFound(admitted([](AsyncWebServerRequest *request){
+        if (isAPMode && APP_CONFIG.features.webUi) {
             // Redirect to WiFi config page for captive portal
             request->redirect("http://192.168.4.1/wifi");
         } else {
             request->send(404, "text/plain", "Not Found");
         }
-    });
+    }));
 
     server.begin();
     Serial.println("Web server started");
 }
+#endif
 
 void setup() {
-    Serial.begin(115200);
+    Serial.begin(SERIAL_BAUD_RATE);
     delay(1000);
 
     Serial.println("\n========================================");
@@ -1486,8 +2789,8 @@ void setup() {
     // Configure advertising
     heart_rate_adv_config.set_scan_rsp = false;
     heart_rate_adv_config.include_txpower = true;
-    heart_rate_adv_config.min_interval = 0x0006;
-    heart_rate_adv_config.max_interval = 0x0010;
+    heart_rate_adv_config.min_interval = APP_CONFIG.ble.advConnMinInterval;
+    heart_rate_adv_config.max_interval = APP_CONFIG.ble.advConnMaxInterval;
     heart_rate_adv_config.appearance = 0x00;
     heart_rate_adv_config.manufacturer_len = 0;
     heart_rate_adv_config.p_manufacturer_data = NULL;
@@ -1502,21 +2805,40 @@ void setup() {
     heart_rate_scan_rsp_config.manufacturer_len = sizeof(test_manufacturer);
     heart_rate_scan_rsp_config.p_manufacturer_data = test_manufacturer;
 
-    heart_rate_adv_params.adv_int_min = 0x100;
-    heart_rate_adv_params.adv_int_max = 0x100;
+    heart_rate_adv_params.adv_int_min = APP_CONFIG.ble.advIntervalMin;
+    heart_rate_adv_params.adv_int_max = APP_CONFIG.ble.advIntervalMax;
     heart_rate_adv_params.adv_type = ADV_TYPE_IND;
     heart_rate_adv_params.own_addr_type = BLE_ADDR_TYPE_RANDOM;
     heart_rate_adv_params.channel_map = ADV_CHNL_ALL;
     heart_rate_adv_params.adv_filter_policy = ADV_FILTER_ALLOW_SCAN_ANY_CON_ANY;
 
+    // Create the module locks before anything that can serve a request
+    task_monitor_begin();
+    irk_index_begin();
+    irk_publish_begin(on_irk_published);
+    rpa_service_begin();
+
+#if !HEADLESS_MODE
+    // Start the log shipper first so it sees the WiFi bring-up
+    log_shipper_begin(APP_CONFIG.net.hostname);
+
     // Setup WiFi
     setupWiFi();
 
+    // Start deferred job scheduler before any handler can post to it
+    deferred_jobs_begin();
+
     // Setup web server
     setupWebServer();
 
+    // Start MQTT publisher
+    mqtt_publisher_begin();
+#endif
+
     // Initialize Bluetooth
     BT_Init();
+    coex_policy_begin();
+    sc_ecc_begin();
 
     // Don't clear bonded devices - allow re-connection to previously paired devices
     // delay(1000);
@@ -1524,26 +2846,45 @@ void setup() {
 
     Serial.println("\n========================================");
     Serial.println("System ready!");
+#if HEADLESS_MODE
+    Serial.println("Headless build - IRKs are reported on this serial port only");
+#else
     Serial.println("Web interface:");
-    Serial.print("  - http://");
-    Serial.print(mdnsHostname);
-    Serial.println(".local");
+    if (APP_CONFIG.features.mdns) {
+        Serial.printf("  - http://%s.local\n", APP_CONFIG.net.hostname);
+    }
     Serial.print("  - http://");
     Serial.println(isAPMode ? WiFi.softAPIP() : WiFi.localIP());
-    Serial.println("BLE Device name: ESP32_IRK_FINDER");
-    Serial.println("Passkey: 123456");
+    Serial.printf("Tasks (core/prio, -1 = any): loop %d/%u, async_tcp %d, deferred %d/%d, mqtt %d/%d, dns %d/%d\n",
+                  (int)xPortGetCoreID(), (unsigned)uxTaskPriorityGet(NULL), CONFIG_ASYNC_TCP_RUNNING_CORE,
+                  TASK_CORE_DEFERRED, TASK_PRIO_DEFERRED,
+                  TASK_CORE_MQTT, TASK_PRIO_MQTT, TASK_CORE_DNS, TASK_PRIO_DNS);
+#endif
+    Serial.printf("BLE Device name: %s\n", APP_CONFIG.ble.name);
+    Serial.printf("Passkey: %06lu\n", (unsigned long)APP_CONFIG.ble.passkey);
+    Serial.printf("Free heap: %u bytes, sketch size: %u bytes\n",
+                  ESP.getFreeHeap(), ESP.getSketchSize());
     Serial.println("========================================\n");
+
+    serial_link_begin(handle_serial_command);
+    serial_link_send_status((uint8_t)esp_ble_get_bond_device_num(), irkRetrieved);
 }
 
 void loop() {
-    // Process DNS requests in AP mode
-    if (isAPMode) {
-        dnsServer.processNextRequest();
-    }
+    // Serve host commands on the serial link
+    serial_link_poll();
 
-    delay(1000);
+#if !HEADLESS_MODE
+    task_monitor_poll();
+#if OTA_ENABLED
+    ota_update_poll();
+#endif
+#endif
+
+    delay(10);
 
-    // Check for bonded devices periodically
+    // Check for bonded devices periodically (picks up bonds restored from
+    // NVS; IRKs already published are dropped by the publication stage)
     static unsigned long lastCheck = 0;
     if (millis() - lastCheck > 5000) {
         lastCheck = millis();
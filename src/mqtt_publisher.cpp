@@ -0,0 +1,250 @@
+/*
+ * MQTT IRK publisher with Home Assistant discovery
+ */
+
+#include <Arduino.h>
+#include "config.h"
+#include "mqtt_publisher.h"
+
+#if MQTT_ENABLED && !HEADLESS_MODE
+
+#include <WiFi.h>
+#include <PubSubClient.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "json_writer.h"
+
+#define MQTT_TAG "MQTT"
+
+// Carries the text already rendered by the publication stage
+struct IrkEvent {
+    uint8_t addr[6];                // identity address
+    uint8_t addrType;
+    uint8_t irk[16];
+    char reversed[33];
+    char base64[25];
+};
+
+static QueueHandle_t irkQueue = NULL;
+static WiFiClient wifiClient;
+static PubSubClient mqttClient(wifiClient);
+static MqttPublisherStats stats = {};
+static char availabilityTopic[64];
+
+static bool connectBroker() {
+    char clientId[32];
+    uint64_t chip = ESP.getEfuseMac();
+    snprintf(clientId, sizeof(clientId), "esp32-irk-finder-%06x", (uint32_t)(chip >> 24) & 0xFFFFFF);
+
+    bool ok;
+    if (strlen(MQTT_USER) > 0) {
+        ok = mqttClient.connect(clientId, MQTT_USER, MQTT_PASSWORD,
+                                availabilityTopic, 0, true, "offline");
+    } else {
+        ok = mqttClient.connect(clientId, availabilityTopic, 0, true, "offline");
+    }
+
+    if (ok) {
+        mqttClient.publish(availabilityTopic, "online", true);
+        ESP_LOGI(MQTT_TAG, "Connected to %s:%d", MQTT_HOST, MQTT_PORT);
+    } else {
+        ESP_LOGW(MQTT_TAG, "Connect to %s:%d failed, state %d", MQTT_HOST, MQTT_PORT, mqttClient.state());
+    }
+    return ok;
+}
+
+// Payload bounds, so both documents are built in fixed stack buffers
+static constexpr size_t STATE_JSON_MAX = jsonsize::braces()
+    + jsonsize::key("mac") + jsonsize::plain(17)
+    + jsonsize::key("addrType") + jsonsize::u32()
+    + jsonsize::key("irk") + jsonsize::plain(32)
+    + jsonsize::key("irkReversed") + jsonsize::plain(32)
+    + jsonsize::key("irkBase64") + jsonsize::plain(24) + 1;
+
+static constexpr size_t TOPIC_MAX = 128;
+
+static constexpr size_t CONFIG_JSON_MAX = jsonsize::braces() * 2
+    + jsonsize::key("name") + jsonsize::plain(4 + 17)
+    + jsonsize::key("unique_id") + jsonsize::plain(11 + 12)
+    + jsonsize::key("state_topic") + jsonsize::plain(TOPIC_MAX)
+    + jsonsize::key("value_template") + jsonsize::plain(26)
+    + jsonsize::key("json_attributes_topic") + jsonsize::plain(TOPIC_MAX)
+    + jsonsize::key("availability_topic") + jsonsize::plain(TOPIC_MAX)
+    + jsonsize::key("icon") + jsonsize::plain(16)
+    + jsonsize::key("device") + jsonsize::key("identifiers") + jsonsize::braces()
+    + jsonsize::plain(16) + jsonsize::key("name") + jsonsize::plain(16) + 1;
+
+static bool publishIrk(const IrkEvent& ev) {
+    char id[13];
+    snprintf(id, sizeof(id), "%02x%02x%02x%02x%02x%02x",
+             ev.addr[0], ev.addr[1], ev.addr[2], ev.addr[3], ev.addr[4], ev.addr[5]);
+    char mac[18];
+    snprintf(mac, sizeof(mac), "%02X:%02X:%02X:%02X:%02X:%02X",
+             ev.addr[0], ev.addr[1], ev.addr[2], ev.addr[3], ev.addr[4], ev.addr[5]);
+
+    char stateTopic[TOPIC_MAX];
+    snprintf(stateTopic, sizeof(stateTopic), "%s/%s/irk", MQTT_TOPIC_PREFIX, id);
+    char configTopic[TOPIC_MAX];
+    snprintf(configTopic, sizeof(configTopic), "%s/sensor/irk_finder_%s/config", MQTT_DISCOVERY_PREFIX, id);
+
+    char state[STATE_JSON_MAX];
+    BufferOut stateOut(state, sizeof(state));
+    JsonWriter<BufferOut> sj(stateOut);
+    sj.beginObject();
+    sj.field("mac", mac);
+    sj.field("addrType", ev.addrType);
+    sj.key("irk").hex(ev.irk, 16);
+    sj.field("irkReversed", ev.reversed);
+    sj.field("irkBase64", ev.base64);
+    sj.endObject();
+
+    char name[22];
+    snprintf(name, sizeof(name), "IRK %s", mac);
+    char uniqueId[24];
+    snprintf(uniqueId, sizeof(uniqueId), "irk_finder_%s", id);
+
+    char config[CONFIG_JSON_MAX];
+    BufferOut configOut(config, sizeof(config));
+    JsonWriter<BufferOut> cj(configOut);
+    cj.beginObject();
+    cj.field("name", name);
+    cj.field("unique_id", uniqueId);
+    cj.field("state_topic", stateTopic);
+    cj.field("value_template", "{{ value_json.irkBase64 }}");
+    cj.field("json_attributes_topic", stateTopic);
+    cj.field("availability_topic", availabilityTopic);
+    cj.field("icon", "mdi:key-variant");
+    cj.key("device").beginObject();
+    cj.key("identifiers").beginArray().value("esp32_irk_finder").endArray();
+    cj.field("name", "ESP32 IRK Finder");
+    cj.endObject();
+    cj.endObject();
+
+    if (stateOut.overflow() || configOut.overflow()) {
+        ESP_LOGE(MQTT_TAG, "Payload exceeds buffer, not published");
+        return true;
+    }
+
+    return mqttClient.publish(configTopic, config, true) &&
+           mqttClient.publish(stateTopic, state, true);
+}
+
+static void mqttTask(void* arg) {
+    uint32_t backoff = MQTT_BACKOFF_MIN_MS;
+    uint32_t nextAttempt = 0;
+    IrkEvent batch[MQTT_BATCH_SIZE];
+
+    for (;;) {
+        if (WiFi.status() != WL_CONNECTED) {
+            stats.connected = false;
+            vTaskDelay(pdMS_TO_TICKS(1000));
+            continue;
+        }
+
+        if (!mqttClient.connected()) {
+            stats.connected = false;
+            if ((int32_t)(millis() - nextAttempt) < 0) {
+                vTaskDelay(pdMS_TO_TICKS(100));
+                continue;
+            }
+            if (!connectBroker()) {
+                nextAttempt = millis() + backoff;
+                backoff = min<uint32_t>(backoff * 2, MQTT_BACKOFF_MAX_MS);
+                continue;
+            }
+            stats.reconnects++;
+            backoff = MQTT_BACKOFF_MIN_MS;
+        }
+        stats.connected = true;
+        mqttClient.loop();
+
+        // Wait briefly for the first capture, then drain whatever else is
+        // queued so a burst goes out in one wake-up.
+        if (xQueueReceive(irkQueue, &batch[0], pdMS_TO_TICKS(200)) != pdTRUE) {
+            continue;
+        }
+        size_t count = 1;
+        while (count < MQTT_BATCH_SIZE && xQueueReceive(irkQueue, &batch[count], 0) == pdTRUE) {
+            count++;
+        }
+        stats.batches++;
+
+        for (size_t i = 0; i < count; i++) {
+            // Topics are retained, so only the newest capture per address matters
+            bool superseded = false;
+            for (size_t j = i + 1; j < count; j++) {
+                if (memcmp(batch[i].addr, batch[j].addr, 6) == 0) {
+                    superseded = true;
+                    break;
+                }
+            }
+            if (superseded) {
+                stats.coalesced++;
+                continue;
+            }
+
+            if (publishIrk(batch[i])) {
+                stats.published++;
+            } else {
+                // Connection dropped mid-batch: requeue at the front and reconnect
+                for (size_t k = count; k > i; k--) {
+                    if (xQueueSendToFront(irkQueue, &batch[k - 1], 0) != pdTRUE) {
+                        stats.dropped++;
+                    }
+                }
+                mqttClient.disconnect();
+                break;
+            }
+        }
+    }
+}
+
+void mqtt_publisher_begin() {
+    snprintf(availabilityTopic, sizeof(availabilityTopic), "%s/status", MQTT_TOPIC_PREFIX);
+    irkQueue = xQueueCreate(MQTT_QUEUE_LENGTH, sizeof(IrkEvent));
+
+    mqttClient.setServer(MQTT_HOST, MQTT_PORT);
+    mqttClient.setBufferSize(CONFIG_JSON_MAX + TOPIC_MAX + 8);
+    mqttClient.setSocketTimeout(2);
+
+    xTaskCreateUniversal(mqttTask, "mqtt", 6144, NULL, TASK_PRIO_MQTT, NULL, TASK_CORE_MQTT);
+    Serial.printf("MQTT publisher started (broker %s:%d)\n", MQTT_HOST, MQTT_PORT);
+}
+
+bool mqtt_publisher_enqueue_irk(const IrkRecord& record) {
+    if (!irkQueue) return false;
+
+    IrkEvent ev;
+    memcpy(ev.addr, record.identity, 6);
+    ev.addrType = record.addrType;
+    memcpy(ev.irk, record.irk, 16);
+    memcpy(ev.reversed, record.reversed, sizeof(ev.reversed));
+    memcpy(ev.base64, record.base64, sizeof(ev.base64));
+
+    if (xQueueSend(irkQueue, &ev, 0) != pdTRUE) {
+        stats.dropped++;
+        return false;
+    }
+    stats.queued++;
+    return true;
+}
+
+MqttPublisherStats mqtt_publisher_stats() {
+    return stats;
+}
+
+#else
+
+void mqtt_publisher_begin() {}
+
+bool mqtt_publisher_enqueue_irk(const IrkRecord& record) {
+    return false;
+}
+
+MqttPublisherStats mqtt_publisher_stats() {
+    MqttPublisherStats none = {};
+    return none;
+}
+
+#endif
@@ -0,0 +1,333 @@
+/*
+ * Streaming firmware update (plain or gzip)
+ */
+
+#include <Arduino.h>
+#include "config.h"
+#include "ota_update.h"
+
+#if OTA_ENABLED && !HEADLESS_MODE
+
+#include <Update.h>
+#include "esp_ota_ops.h"
+#include "mbedtls/sha256.h"
+
+// tinfl from the ROM copy of miniz
+#if CONFIG_IDF_TARGET_ESP32
+#include "esp32/rom/miniz.h"
+#elif CONFIG_IDF_TARGET_ESP32S3
+#include "esp32s3/rom/miniz.h"
+#elif CONFIG_IDF_TARGET_ESP32C3
+#include "esp32c3/rom/miniz.h"
+#endif
+
+#define OTA_TAG "OTA"
+
+// gzip member header flags (RFC 1952)
+static const uint8_t GZIP_FHCRC = 0x02;
+static const uint8_t GZIP_FEXTRA = 0x04;
+static const uint8_t GZIP_FNAME = 0x08;
+static const uint8_t GZIP_FCOMMENT = 0x10;
+
+enum StreamState {
+    DETECT,                     // first two bytes: gzip magic or not
+    GZIP_HEADER,                // fixed 10-byte header
+    GZIP_EXTRA_LEN,
+    GZIP_SKIP,                  // FEXTRA payload or header CRC
+    GZIP_NAME,
+    GZIP_COMMENT,
+    GZIP_DEFLATE,
+    GZIP_DONE,                  // trailer ignored; the SHA-256 covers the image
+    PLAIN
+};
+
+// tinfl writes into the window as a ring; every filled stretch goes to
+// flash before the ring wraps over it
+struct Inflater {
+    tinfl_decompressor decomp;
+    uint8_t window[TINFL_LZ_DICT_SIZE];
+};
+
+struct Session {
+    uint32_t id;
+    Inflater* inflater;         // gzip uploads only
+    mbedtls_sha256_context sha;
+    uint8_t expected[32];
+    StreamState state;
+    uint8_t flags;
+    uint8_t header[10];
+    size_t headerLen;
+    uint32_t skip;
+    size_t windowPos;
+    uint32_t startMs;
+    OtaResult result;
+};
+
+static Session* session = NULL;
+static uint32_t nextId = 1;
+
+static bool fail(const char* error) {
+    if (!session->result.error) session->result.error = error;
+    return false;
+}
+
+static bool parseSha256(const char* hex, uint8_t* out) {
+    if (!hex || strlen(hex) != 64) return false;
+    for (int i = 0; i < 32; i++) {
+        uint8_t v = 0;
+        for (int j = 0; j < 2; j++) {
+            char c = hex[i * 2 + j];
+            v <<= 4;
+            if (c >= '0' && c <= '9') v |= (uint8_t)(c - '0');
+            else if (c >= 'a' && c <= 'f') v |= (uint8_t)(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') v |= (uint8_t)(c - 'A' + 10);
+            else return false;
+        }
+        out[i] = v;
+    }
+    return true;
+}
+
+// Uncompressed image bytes: hash and write to the OTA slot
+static bool emit(const uint8_t* data, size_t len) {
+    if (Update.write((uint8_t*)data, len) != len) return fail("flash_write_failed");
+    mbedtls_sha256_update(&session->sha, data, len);
+    session->result.written += len;
+    return true;
+}
+
+// Move on to the next optional header field, or to the deflate stream
+static void nextHeaderField() {
+    Session& s = *session;
+    s.headerLen = 0;
+    if (s.flags & GZIP_FEXTRA) {
+        s.state = GZIP_EXTRA_LEN;
+    } else if (s.flags & GZIP_FNAME) {
+        s.state = GZIP_NAME;
+    } else if (s.flags & GZIP_FCOMMENT) {
+        s.state = GZIP_COMMENT;
+    } else if (s.flags & GZIP_FHCRC) {
+        s.flags &= ~GZIP_FHCRC;
+        s.skip = 2;
+        s.state = GZIP_SKIP;
+    } else {
+        tinfl_init(&s.inflater->decomp);
+        s.windowPos = 0;
+        s.state = GZIP_DEFLATE;
+    }
+}
+
+static bool inflateChunk(const uint8_t*& data, size_t& len) {
+    Inflater* inf = session->inflater;
+    for (;;) {
+        size_t inBytes = len;
+        size_t outBytes = TINFL_LZ_DICT_SIZE - session->windowPos;
+        tinfl_status status = tinfl_decompress(&inf->decomp, data, &inBytes, inf->window,
+                                               inf->window + session->windowPos, &outBytes,
+                                               TINFL_FLAG_HAS_MORE_INPUT);
+        data += inBytes;
+        len -= inBytes;
+        if (outBytes && !emit(inf->window + session->windowPos, outBytes)) return false;
+        session->windowPos = (session->windowPos + outBytes) & (TINFL_LZ_DICT_SIZE - 1);
+
+        if (status == TINFL_STATUS_DONE) {
+            session->state = GZIP_DONE;
+            return true;
+        }
+        if (status < TINFL_STATUS_DONE) return fail("corrupt_gzip");
+        if (status == TINFL_STATUS_NEEDS_MORE_INPUT) return true;
+        // TINFL_STATUS_HAS_MORE_OUTPUT: the window is full, flush and go on
+    }
+}
+
+static bool process(const uint8_t* data, size_t len) {
+    Session& s = *session;
+    while (len > 0) {
+        switch (s.state) {
+            case DETECT:
+                s.header[s.headerLen++] = *data++;
+                len--;
+                if ((s.headerLen == 1 && s.header[0] != 0x1f) || (s.headerLen == 2 && s.header[1] != 0x8b)) {
+                    s.state = PLAIN;
+                    if (!emit(s.header, s.headerLen)) return false;
+                } else if (s.headerLen == 2) {
+                    s.inflater = (Inflater*)malloc(sizeof(Inflater));
+                    if (!s.inflater) return fail("out_of_memory");
+                    s.result.compressed = true;
+                    s.state = GZIP_HEADER;
+                }
+                break;
+
+            case GZIP_HEADER:
+                s.header[s.headerLen++] = *data++;
+                len--;
+                if (s.headerLen == sizeof(s.header)) {
+                    if (s.header[2] != 8) return fail("unsupported_gzip");   // CM must be deflate
+                    s.flags = s.header[3];
+                    nextHeaderField();
+                }
+                break;
+
+            case GZIP_EXTRA_LEN:
+                s.header[s.headerLen++] = *data++;
+                len--;
+                if (s.headerLen == 2) {
+                    s.flags &= ~GZIP_FEXTRA;
+                    s.skip = s.header[0] | ((uint32_t)s.header[1] << 8);
+                    s.state = GZIP_SKIP;
+                    if (s.skip == 0) nextHeaderField();
+                }
+                break;
+
+            case GZIP_SKIP: {
+                size_t n = len < s.skip ? len : s.skip;
+                data += n;
+                len -= n;
+                s.skip -= n;
+                if (s.skip == 0) nextHeaderField();
+                break;
+            }
+
+            case GZIP_NAME:
+            case GZIP_COMMENT:
+                // NUL-terminated strings
+                if (*data++ == 0) {
+                    s.flags &= s.state == GZIP_NAME ? ~GZIP_FNAME : ~GZIP_FCOMMENT;
+                    nextHeaderField();
+                }
+                len--;
+                break;
+
+            case GZIP_DEFLATE:
+                if (!inflateChunk(data, len)) return false;
+                break;
+
+            case GZIP_DONE:
+                len = 0;
+                break;
+
+            case PLAIN:
+                if (!emit(data, len)) return false;
+                len = 0;
+                break;
+        }
+    }
+    return true;
+}
+
+static void release() {
+    mbedtls_sha256_free(&session->sha);
+    free(session->inflater);
+    free(session);
+    session = NULL;
+}
+
+uint32_t ota_update_begin(const char* expectedSha256, OtaResult* result) {
+    memset(result, 0, sizeof(*result));
+    uint8_t expected[32];
+    if (session) {
+        result->error = "busy";
+    } else if (!parseSha256(expectedSha256, expected)) {
+        result->error = "invalid_sha256";
+    } else if (!esp_ota_get_next_update_partition(NULL)) {
+        result->error = "no_ota_partition";
+    } else if (!(session = (Session*)calloc(1, sizeof(Session)))) {
+        result->error = "out_of_memory";
+    } else if (!Update.begin(UPDATE_SIZE_UNKNOWN)) {
+        free(session);
+        session = NULL;
+        result->error = "update_begin_failed";
+    }
+    if (result->error) return 0;
+
+    session->id = nextId++;
+    memcpy(session->expected, expected, sizeof(expected));
+    mbedtls_sha256_init(&session->sha);
+    mbedtls_sha256_starts(&session->sha, 0);
+    session->startMs = millis();
+    session->result.minFreeHeap = ESP.getFreeHeap();
+    ESP_LOGI(OTA_TAG, "Update started, slot %s", esp_ota_get_next_update_partition(NULL)->label);
+    return session->id;
+}
+
+bool ota_update_write(const uint8_t* data, size_t len) {
+    if (!session || session->result.error) return false;
+    session->result.received += len;
+    bool ok = process(data, len);
+    uint32_t freeHeap = ESP.getFreeHeap();
+    if (freeHeap < session->result.minFreeHeap) session->result.minFreeHeap = freeHeap;
+    return ok;
+}
+
+bool ota_update_finish(OtaResult* result) {
+    if (!session) {
+        memset(result, 0, sizeof(*result));
+        result->error = "not_started";
+        return false;
+    }
+
+    Session& s = *session;
+    if (!s.result.error) {
+        if (s.result.written == 0) {
+            fail("empty_image");
+        } else if (s.result.compressed && s.state != GZIP_DONE) {
+            fail("truncated_gzip");
+        }
+    }
+    if (!s.result.error) {
+        uint8_t digest[32];
+        mbedtls_sha256_finish(&s.sha, digest);
+        if (memcmp(digest, s.expected, sizeof(digest)) != 0) fail("sha256_mismatch");
+    }
+    // Update.end() checks the image and only then switches the boot slot
+    if (!s.result.error && !Update.end(true)) fail("image_rejected");
+    if (s.result.error) Update.abort();
+
+    s.result.elapsedMs = millis() - s.startMs;
+    *result = s.result;
+    if (result->error) {
+        ESP_LOGW(OTA_TAG, "Update failed: %s (%u bytes received)", result->error, result->received);
+    } else {
+        ESP_LOGI(OTA_TAG, "Update verified: %u bytes%s in %u ms, min free heap %u", result->written,
+                 result->compressed ? " (gzip)" : "", result->elapsedMs, result->minFreeHeap);
+    }
+    release();
+    return !result->error;
+}
+
+void ota_update_abort(uint32_t id) {
+    if (!session || session->id != id) return;
+    ESP_LOGW(OTA_TAG, "Update aborted after %u bytes", session->result.received);
+    Update.abort();
+    release();
+}
+
+bool ota_update_active() {
+    return session != NULL;
+}
+
+#ifdef CONFIG_APP_ROLLBACK_ENABLE
+// Keep a new image pending until ota_update_poll() has seen it run, instead
+// of the Arduino core marking it valid before setup()
+extern "C" bool verifyRollbackLater() {
+    return true;
+}
+
+void ota_update_poll() {
+    static bool checked = false;
+    if (checked || millis() < OTA_CONFIRM_MS) return;
+    checked = true;
+
+    esp_ota_img_states_t state;
+    if (esp_ota_get_state_partition(esp_ota_get_running_partition(), &state) == ESP_OK &&
+        state == ESP_OTA_IMG_PENDING_VERIFY) {
+        esp_ota_mark_app_valid_cancel_rollback();
+        ESP_LOGI(OTA_TAG, "Updated firmware confirmed");
+    }
+}
+#else
+void ota_update_poll() {
+}
+#endif
+
+#endif
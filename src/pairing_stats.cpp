@@ -0,0 +1,117 @@
+/*
+ * Pairing timing and outcome statistics
+ */
+
+#include <Arduino.h>
+#include "pairing_stats.h"
+
+static PairingPolicyStats stats[PAIRING_POLICY_COUNT];
+static PairingLatencyStats keyLatency[2];
+static PairingStageStats stages;
+static bool active = false;
+static bool keySeen = false;
+static uint8_t activePolicy = 0;
+static bool activeFastConn = false;
+static uint32_t connectedAt = 0;
+static bool requestSeen = false;
+static uint32_t requestAt = 0;
+static uint32_t keyAt = 0;
+
+void pairing_stats_connect(uint8_t policy, bool fastConn) {
+    if (policy >= PAIRING_POLICY_COUNT) policy = 0;
+    active = true;
+    keySeen = false;
+    requestSeen = false;
+    activePolicy = policy;
+    activeFastConn = fastConn;
+    connectedAt = millis();
+    stats[policy].attempts++;
+}
+
+// The phone's pairing request (SEC_REQ_EVT on the peripheral)
+void pairing_stats_request() {
+    if (!active || requestSeen || keySeen) return;
+    requestSeen = true;
+    requestAt = millis();
+}
+
+void pairing_stats_key() {
+    if (!active || keySeen) return;
+    keySeen = true;
+    keyAt = millis();
+
+    uint32_t ms = keyAt - connectedAt;
+    PairingLatencyStats& s = keyLatency[activeFastConn ? 1 : 0];
+    s.samples++;
+    s.totalMs += ms;
+    s.lastMs = ms;
+    if (s.minMs == 0 || ms < s.minMs) s.minMs = ms;
+    if (ms > s.maxMs) s.maxMs = ms;
+}
+
+void pairing_stats_complete(bool success) {
+    if (!active) return;
+    active = false;
+
+    PairingPolicyStats& s = stats[activePolicy];
+    if (!success) {
+        s.failures++;
+        return;
+    }
+
+    uint32_t now = millis();
+    uint32_t ms = now - connectedAt;
+    s.successes++;
+    s.totalMs += ms;
+    s.lastMs = ms;
+    if (s.minMs == 0 || ms < s.minMs) s.minMs = ms;
+    if (ms > s.maxMs) s.maxMs = ms;
+
+    // Without a reported pairing request the whole lead-in counts as security
+    if (keySeen) {
+        uint32_t securityFrom = requestSeen ? requestAt : connectedAt;
+        uint32_t split[PAIRING_STAGE_COUNT] = {securityFrom - connectedAt, keyAt - securityFrom, now - keyAt};
+        stages.samples++;
+        for (uint8_t i = 0; i < PAIRING_STAGE_COUNT; i++) {
+            stages.totalMs[i] += split[i];
+            stages.lastMs[i] = split[i];
+            if (split[i] > stages.maxMs[i]) stages.maxMs[i] = split[i];
+        }
+    }
+}
+
+// A link that drops before authentication completes is a failed attempt
+void pairing_stats_disconnect() {
+    if (active) {
+        pairing_stats_complete(false);
+    }
+}
+
+bool pairing_stats_active() {
+    return active;
+}
+
+PairingPolicyStats pairing_stats_get(uint8_t policy) {
+    if (policy >= PAIRING_POLICY_COUNT) {
+        PairingPolicyStats none = {};
+        return none;
+    }
+    return stats[policy];
+}
+
+PairingLatencyStats pairing_stats_key_latency(bool fastConn) {
+    return keyLatency[fastConn ? 1 : 0];
+}
+
+PairingStageStats pairing_stats_stages() {
+    return stages;
+}
+
+const char* pairing_stage_name(uint8_t stage) {
+    switch (stage) {
+        case STAGE_REQUEST: return "request";
+        case STAGE_SECURITY: return "security";
+        case STAGE_KEYS: return "keys";
+        default: return "unknown";
+    }
+}
@@ -0,0 +1,105 @@
+/*
+ * On-device batch RPA resolution
+ */
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_gap_ble_api.h"
+#include "config.h"
+#include "rpa_service.h"
+#include "rpa_cache.h"
+
+#if RESOLVE_HW_AES
+#include "mbedtls/aes.h"
+
+// mbedTLS AES context per IRK, set up once and reused for every address.
+// On the ESP32 family mbedTLS is built with the AES peripheral enabled.
+class MbedtlsCipher {
+public:
+    MbedtlsCipher() { mbedtls_aes_init(&ctx_); }
+    ~MbedtlsCipher() { mbedtls_aes_free(&ctx_); }
+
+    void setKey(const uint8_t key[16]) {
+        mbedtls_aes_setkey_enc(&ctx_, key, 128);
+    }
+
+    void encrypt(const uint8_t in[16], uint8_t out[16]) const {
+        mbedtls_aes_crypt_ecb(&ctx_, MBEDTLS_AES_ENCRYPT, in, out);
+    }
+
+private:
+    mutable mbedtls_aes_context ctx_;
+};
+
+typedef MbedtlsCipher Cipher;
+#else
+#include "aes128.h"
+typedef aes128::Cipher Cipher;
+#endif
+
+#define RPA_TAG "RPA"
+
+static rpa::CachedResolver<Cipher, RESOLVE_MAX_IRKS, RESOLVE_CACHE_SLOTS> resolver(RESOLVE_CACHE_TTL_MS);
+static rpa::Identity identities[RESOLVE_MAX_IRKS];
+static SemaphoreHandle_t lock = NULL;
+static bool stale = true;
+static int loadedBonds = -1;
+
+void rpa_service_begin() {
+    if (!lock) {
+        lock = xSemaphoreCreateMutex();
+    }
+}
+
+void rpa_service_invalidate() {
+    stale = true;
+}
+
+// Rebuild the IRK set from the bond list; caller holds the lock
+static void reload() {
+    int num = esp_ble_get_bond_device_num();
+    resolver.clear();
+    loadedBonds = num;
+    stale = false;
+    if (num <= 0) return;
+
+    esp_ble_bond_dev_t* list = (esp_ble_bond_dev_t*)malloc(sizeof(esp_ble_bond_dev_t) * num);
+    if (!list) {
+        stale = true;
+        return;
+    }
+    esp_ble_get_bond_device_list(&num, list);
+
+    for (int i = 0; i < num; i++) {
+        if (!(list[i].bond_key.key_mask & ESP_BLE_ID_KEY_MASK)) continue;
+        uint16_t idx = resolver.size();
+        if (!resolver.add(list[i].bond_key.pid_key.irk)) {
+            ESP_LOGW(RPA_TAG, "More than %d bonded IRKs, ignoring the rest", RESOLVE_MAX_IRKS);
+            break;
+        }
+        memcpy(identities[idx].addr, list[i].bond_key.pid_key.static_addr, 6);
+        identities[idx].addrType = list[i].bond_key.pid_key.addr_type;
+    }
+    free(list);
+    ESP_LOGI(RPA_TAG, "Resolver loaded %u IRKs", resolver.size());
+}
+
+RpaBatchStats rpa_service_resolve(const uint8_t (*addrs)[6], int* results, size_t n, rpa::Identity* out) {
+    RpaBatchStats stats = {};
+    stats.hardwareAes = RESOLVE_HW_AES;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (stale || esp_ble_get_bond_device_num() != loadedBonds) {
+        reload();
+    }
+
+    uint32_t start = micros();
+    stats.matched = rpa::resolveBatch(resolver, addrs, results, n, millis());
+    stats.elapsedUs = micros() - start;
+    stats.irks = resolver.size();
+    memcpy(out, identities, sizeof(rpa::Identity) * resolver.size());
+    xSemaphoreGive(lock);
+
+    return stats;
+}
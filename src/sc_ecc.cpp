@@ -0,0 +1,53 @@
+/*
+ * LE Secure Connections P-256 cost probe
+ */
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_system.h"
+#include "config.h"
+#include "sc_ecc.h"
+
+#if SC_ECC_HW
+#include "sc_ecc_mbedtls.h"
+#endif
+
+#define SC_ECC_TAG "SC_ECC"
+
+static ScEccStats stats = {};
+static volatile bool finished = false;
+
+#if SC_ECC_HW
+static int fillRandom(void* ctx, unsigned char* buf, size_t len) {
+    esp_fill_random(buf, len);
+    return 0;
+}
+
+static uint32_t clockUs() {
+    return micros();
+}
+
+static void probeTask(void* param) {
+    scecc::measure(stats.mbedtls, fillRandom, NULL, clockUs);
+    ESP_LOGI(SC_ECC_TAG, "P-256 mbedTLS: key pair %u us, DHKey %u us, %s",
+             stats.mbedtls.keyPairUs, stats.mbedtls.dhKeyUs, stats.mbedtls.valid ? "valid" : "INVALID");
+    stats.done = true;
+    finished = true;
+    vTaskDelete(NULL);
+}
+#endif
+
+void sc_ecc_begin() {
+#if SC_ECC_PROBE && SC_ECC_HW
+    xTaskCreateUniversal(probeTask, "sc_ecc", 6144, NULL, tskIDLE_PRIORITY + 1, NULL, -1);
+#endif
+}
+
+ScEccStats sc_ecc_stats() {
+    if (!finished) {
+        ScEccStats pending = {};
+        return pending;
+    }
+    return stats;
+}
@@ -0,0 +1,79 @@
+/*
+ * Framed binary IRK link on the serial port
+ */
+
+#include <Arduino.h>
+#include "config.h"
+#include "serial_link.h"
+
+static serial_link_command_cb_t commandHandler = NULL;
+static irkframe::Parser parser;
+
+void serial_link_begin(serial_link_command_cb_t onCommand) {
+    commandHandler = onCommand;
+    parser.reset();
+}
+
+// Drain pending host bytes and dispatch complete command frames
+void serial_link_poll() {
+    if (!SERIAL_PROTOCOL_ENABLED) return;
+
+    while (Serial.available() > 0) {
+        if (parser.feed((uint8_t)Serial.read()) && commandHandler) {
+            commandHandler(parser.type(), parser.payload(), parser.length());
+        }
+    }
+}
+
+// Frames are encoded on the stack and written with a single write() call so
+// they never interleave with output from other tasks.
+void serial_link_send(uint8_t type, const uint8_t* payload, size_t len) {
+    if (!SERIAL_PROTOCOL_ENABLED) return;
+
+    uint8_t frame[irkframe::MAX_FRAME];
+    size_t n = irkframe::encode(type, payload, len, frame, sizeof(frame));
+    if (n > 0) {
+        Serial.write(frame, n);
+    }
+}
+
+void serial_link_send_irk(const uint8_t* addr, uint8_t addrType, const uint8_t* irk) {
+    uint8_t payload[irkframe::IRK_CAPTURED_SIZE];
+    memcpy(payload, addr, 6);
+    payload[6] = addrType;
+    memcpy(&payload[7], irk, 16);
+    serial_link_send(irkframe::EVT_IRK_CAPTURED, payload, sizeof(payload));
+}
+
+void serial_link_send_bond_entry(const uint8_t* addr, uint8_t addrType) {
+    uint8_t payload[irkframe::BOND_ENTRY_SIZE];
+    memcpy(payload, addr, 6);
+    payload[6] = addrType;
+    serial_link_send(irkframe::EVT_BOND_ENTRY, payload, sizeof(payload));
+}
+
+void serial_link_send_bond_removed(const uint8_t* addr) {
+    uint8_t payload[irkframe::BOND_REMOVED_SIZE] = {0};
+    if (addr) {
+        memcpy(payload, addr, 6);
+    }
+    serial_link_send(irkframe::EVT_BOND_REMOVED, payload, sizeof(payload));
+}
+
+void serial_link_send_list_end(uint8_t count) {
+    serial_link_send(irkframe::EVT_LIST_END, &count, 1);
+}
+
+void serial_link_send_status(uint8_t bonds, bool irkRetrieved) {
+    uint8_t payload[irkframe::STATUS_SIZE];
+    irkframe::putU32(&payload[0], millis());
+    irkframe::putU32(&payload[4], ESP.getFreeHeap());
+    payload[8] = bonds;
+    payload[9] = irkRetrieved ? 1 : 0;
+    serial_link_send(irkframe::EVT_STATUS, payload, sizeof(payload));
+}
+
+void serial_link_send_ack(uint8_t command, uint8_t status) {
+    uint8_t payload[2] = {command, status};
+    serial_link_send(irkframe::EVT_ACK, payload, sizeof(payload));
+}
@@ -0,0 +1,219 @@
+/*
+ * Task CPU monitor and BT callback budget
+ */
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "config.h"
+#include "event_trace.h"
+#include "task_monitor.h"
+
+#define TASK_MONITOR_TAG "TASKMON"
+
+// Only /api/tasks reads the samples, so the sampler is built with it; the BT
+// callback budget is always checked
+#define TASK_MONITOR_SAMPLER HTTP_DEBUG_ENDPOINTS
+
+// uxTaskGetSystemState() and the run-time counters are optional FreeRTOS
+// features. The task list (stack, priority, core) only needs the trace
+// facility; CPU shares also need the run-time counters. Without either, only
+// the BT callback budget is available.
+#if TASK_MONITOR_SAMPLER && defined(configUSE_TRACE_FACILITY) && configUSE_TRACE_FACILITY
+#define TASK_MONITOR_TASKS 1
+#else
+#define TASK_MONITOR_TASKS 0
+#endif
+
+#if TASK_MONITOR_TASKS && defined(configGENERATE_RUN_TIME_STATS) && configGENERATE_RUN_TIME_STATS
+#define TASK_MONITOR_RUNTIME 1
+#else
+#define TASK_MONITOR_RUNTIME 0
+#endif
+
+static SemaphoreHandle_t lock = NULL;
+static TaskMonitorStats stats = {};
+static BtCallbackStats btStats = {};
+
+#if TASK_MONITOR_TASKS
+static TaskStatus_t status[TASK_MONITOR_MAX_TASKS];
+static TaskInfo tasks[TASK_MONITOR_MAX_TASKS];
+static size_t taskCount = 0;
+#endif
+
+#if TASK_MONITOR_RUNTIME
+struct TaskRun {
+    UBaseType_t number;
+    uint32_t runTime;
+};
+
+// One entry per sample in the window; the oldest is the baseline
+struct Snapshot {
+    uint32_t totalRunTime;
+    uint32_t atMs;
+    uint16_t count;
+    TaskRun runs[TASK_MONITOR_MAX_TASKS];
+};
+
+static Snapshot window[TASK_MONITOR_WINDOW + 1];
+static uint16_t windowHead = 0;     // next slot to write
+static uint16_t windowCount = 0;
+#endif
+
+#if TASK_MONITOR_SAMPLER
+static uint32_t lastSampleMs = 0;
+static int64_t firstSampleUs = 0;
+static uint64_t sampleTotalUs = 0;
+#endif
+
+void task_monitor_begin() {
+    if (!lock) {
+        lock = xSemaphoreCreateMutex();
+    }
+    stats.runtimeStats = TASK_MONITOR_RUNTIME;
+}
+
+#if TASK_MONITOR_RUNTIME
+static uint32_t baselineRunTime(const Snapshot& base, UBaseType_t number, bool* found) {
+    for (uint16_t i = 0; i < base.count; i++) {
+        if (base.runs[i].number == number) {
+            *found = true;
+            return base.runs[i].runTime;
+        }
+    }
+    *found = false;
+    return 0;
+}
+
+// Add a snapshot of the run-time counters and recompute every task's share
+// against the oldest one
+static void sampleRunTime(UBaseType_t n, uint32_t total) {
+    Snapshot& snap = window[windowHead];
+    snap.totalRunTime = total;
+    snap.atMs = millis();
+    snap.count = (uint16_t)n;
+    for (UBaseType_t i = 0; i < n; i++) {
+        snap.runs[i].number = status[i].xTaskNumber;
+        snap.runs[i].runTime = status[i].ulRunTimeCounter;
+    }
+    windowHead = (windowHead + 1) % (TASK_MONITOR_WINDOW + 1);
+    if (windowCount < TASK_MONITOR_WINDOW + 1) windowCount++;
+
+    const Snapshot& base = window[(windowHead + (TASK_MONITOR_WINDOW + 1) - windowCount) % (TASK_MONITOR_WINDOW + 1)];
+    uint32_t elapsed = total - base.totalRunTime;
+
+    for (UBaseType_t i = 0; i < n; i++) {
+        bool found;
+        uint32_t before = baselineRunTime(base, status[i].xTaskNumber, &found);
+        uint32_t ran = status[i].ulRunTimeCounter - (found ? before : 0);
+        tasks[i].cpuPermille = elapsed ? (uint16_t)((uint64_t)ran * 1000 / elapsed) : 0;
+    }
+    stats.windowMs = snap.atMs - base.atMs;
+}
+#endif
+
+#if TASK_MONITOR_TASKS
+static void sample() {
+    uint32_t total = 0;
+    UBaseType_t n = uxTaskGetSystemState(status, TASK_MONITOR_MAX_TASKS, &total);
+    if (n == 0) {
+        stats.truncated++;
+        return;
+    }
+
+    for (UBaseType_t i = 0; i < n; i++) {
+        TaskInfo& t = tasks[i];
+        strncpy(t.name, status[i].pcTaskName, TASK_NAME_LEN - 1);
+        t.name[TASK_NAME_LEN - 1] = '\0';
+        t.priority = (uint8_t)status[i].uxCurrentPriority;
+        t.stackFree = status[i].usStackHighWaterMark;   // bytes on ESP-IDF
+#if defined(configTASKLIST_INCLUDE_COREID) && configTASKLIST_INCLUDE_COREID
+        t.core = status[i].xCoreID == tskNO_AFFINITY ? -1 : (int8_t)status[i].xCoreID;
+#else
+        t.core = -1;
+#endif
+        t.cpuPermille = 0;
+    }
+#if TASK_MONITOR_RUNTIME
+    sampleRunTime(n, total);
+#endif
+    taskCount = n;
+}
+#endif
+
+#if TASK_MONITOR_SAMPLER
+void task_monitor_poll() {
+    uint32_t now = millis();
+    if (stats.samples > 0 && now - lastSampleMs < TASK_MONITOR_SAMPLE_MS) return;
+    lastSampleMs = now;
+
+    int64_t start = esp_timer_get_time();
+    if (firstSampleUs == 0) firstSampleUs = start;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+#if TASK_MONITOR_TASKS
+    sample();
+#endif
+    uint32_t us = (uint32_t)(esp_timer_get_time() - start);
+    stats.samples++;
+    stats.lastSampleUs = us;
+    if (us > stats.maxSampleUs) stats.maxSampleUs = us;
+    sampleTotalUs += us;
+    int64_t span = esp_timer_get_time() - firstSampleUs;
+    stats.overheadPpm = span > 0 ? (uint32_t)(sampleTotalUs * 1000000ULL / (uint64_t)span) : 0;
+    xSemaphoreGive(lock);
+}
+#else
+void task_monitor_poll() {}
+#endif
+
+size_t task_monitor_tasks(TaskInfo* out, size_t max) {
+#if TASK_MONITOR_TASKS
+    xSemaphoreTake(lock, portMAX_DELAY);
+    size_t n = taskCount < max ? taskCount : max;
+    memcpy(out, tasks, n * sizeof(TaskInfo));
+    xSemaphoreGive(lock);
+    return n;
+#else
+    (void)out;
+    (void)max;
+    return 0;
+#endif
+}
+
+TaskMonitorStats task_monitor_stats() {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    TaskMonitorStats s = stats;
+    xSemaphoreGive(lock);
+    return s;
+}
+
+// Runs on the Bluedroid task only, like the pairing statistics
+void task_monitor_bt_callback(uint8_t source, uint8_t event, uint32_t elapsedUs) {
+    btStats.calls++;
+    if (elapsedUs > btStats.maxUs) {
+        btStats.maxUs = elapsedUs;
+        btStats.maxSource = source;
+        btStats.maxEvent = event;
+    }
+    if (elapsedUs <= BT_CALLBACK_BUDGET_US) return;
+
+    btStats.overruns++;
+    btStats.lastOverrunUs = elapsedUs;
+    btStats.lastOverrunSource = source;
+    btStats.lastOverrunEvent = event;
+    btStats.lastOverrunMs = millis();
+
+    TraceEvent ev = {};
+    ev.source = source;
+    ev.event = event;
+    ESP_LOGW(TASK_MONITOR_TAG, "BT %s callback %s (%u) took %u us, budget %u us",
+             source == TRACE_GAP ? "GAP" : "GATTS", event_trace_name(ev), event,
+             elapsedUs, (unsigned)BT_CALLBACK_BUDGET_US);
+}
+
+BtCallbackStats task_monitor_bt_stats() {
+    return btStats;
+}
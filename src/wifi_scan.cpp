@@ -0,0 +1,92 @@
+/*
+ * Cached asynchronous WiFi scan
+ */
+
+#include <Arduino.h>
+#include "config.h"
+
+#if !HEADLESS_MODE
+
+#include <WiFi.h>
+#include "http_admission.h"
+#include "wifi_scan.h"
+
+static WiFiScanNetwork cache[WIFI_SCAN_MAX_RESULTS];
+static size_t cacheCount = 0;
+static bool cacheValid = false;
+static uint32_t cacheTime = 0;
+static bool scanning = false;
+
+static void harvest(int found) {
+    cacheCount = 0;
+
+    for (int i = 0; i < found; i++) {
+        // Read the driver's record directly rather than String copies
+        const wifi_ap_record_t* rec = (const wifi_ap_record_t*)WiFi.getScanInfoByIndex(i);
+        if (!rec) continue;
+        const char* ssid = (const char*)rec->ssid;
+        if (ssid[0] == '\0') continue;   // hidden network
+
+        int8_t rssi = rec->rssi;
+
+        // De-duplicate by SSID, keeping the strongest access point
+        size_t j = 0;
+        while (j < cacheCount && strcmp(cache[j].ssid, ssid) != 0) j++;
+        if (j < cacheCount) {
+            if (rssi <= cache[j].rssi) continue;
+        } else if (cacheCount < WIFI_SCAN_MAX_RESULTS) {
+            j = cacheCount++;
+            strlcpy(cache[j].ssid, ssid, sizeof(cache[j].ssid));
+        } else if (rssi > cache[cacheCount - 1].rssi) {
+            // Full: replace the weakest entry (the table is kept sorted)
+            j = cacheCount - 1;
+            strlcpy(cache[j].ssid, ssid, sizeof(cache[j].ssid));
+        } else {
+            continue;
+        }
+
+        cache[j].rssi = rssi;
+        cache[j].channel = rec->primary;
+        cache[j].secure = rec->authmode != WIFI_AUTH_OPEN;
+
+        // Bubble the updated entry up to keep strongest-first order
+        while (j > 0 && cache[j - 1].rssi < cache[j].rssi) {
+            WiFiScanNetwork tmp = cache[j - 1];
+            cache[j - 1] = cache[j];
+            cache[j] = tmp;
+            j--;
+        }
+    }
+
+    cacheValid = true;
+    cacheTime = millis();
+}
+
+WiFiScanSnapshot wifi_scan_refresh() {
+    if (scanning) {
+        int16_t result = WiFi.scanComplete();
+        if (result >= 0) {
+            harvest(result);
+            WiFi.scanDelete();
+            scanning = false;
+        } else if (result == WIFI_SCAN_FAILED) {
+            scanning = false;
+        }
+    }
+
+    bool stale = !cacheValid || millis() - cacheTime > WIFI_SCAN_TTL_MS;
+    if (stale && !scanning && !http_admission_pairing_active()) {
+        // async=true returns immediately; results are picked up on a later call
+        scanning = WiFi.scanNetworks(true) == WIFI_SCAN_RUNNING;
+    }
+
+    WiFiScanSnapshot snap;
+    snap.networks = cache;
+    snap.count = cacheCount;
+    snap.valid = cacheValid;
+    snap.scanning = scanning;
+    snap.ageMs = cacheValid ? millis() - cacheTime : 0;
+    return snap;
+}
+
+#endif
@@ -0,0 +1,154 @@
+/*
+ * irk_store_bench - insert / lookup / repeat-pairing timings of irk_store.h
+ *
+ * Fills a store with random identities, then times lookups by address and
+ * by IRK (hits and misses), repeat pairings of known devices, removal, and
+ * a cursor walk over every record in PAGE_SIZE pages (as GET /api/devices
+ * does). Every result is checked so a broken index fails loudly. A known
+ * address paired with another record's IRK must merge the two records.
+ *
+ *   irk_store_bench [entries] [rounds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "irk_store.h"
+
+static const uint16_t CAPACITY = 16384;
+static const uint16_t PAGE_SIZE = 16;
+
+struct Identity {
+    uint8_t addr[6];
+    uint8_t irk[16];
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static double nsPerOp(Clock::time_point start, size_t ops) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ops;
+}
+
+static void fail(const char* what, size_t i) {
+    fprintf(stderr, "FAIL: %s at %zu\n", what, i);
+    exit(1);
+}
+
+// Device a, the last record, pairs again with b's IRK: b is merged into a,
+// which moves a into b's slot
+static void checkMerge(const Identity& a, const Identity& b) {
+    irkstore::Store<4> s;
+    s.upsert(b.addr, 0, b.irk, 10);
+    s.upsert(a.addr, 0, a.irk, 20);
+    if (s.upsert(a.addr, 0, b.irk, 30) != irkstore::UPDATED) fail("merge result", 0);
+    if (s.size() != 1) fail("merge size", s.size());
+    const irkstore::Record* r = s.findByIrk(b.irk);
+    if (!r || r != s.findByAddr(a.addr)) fail("merge lookup", 0);
+    if (s.findByAddr(b.addr) || s.findByIrk(a.irk)) fail("merge stale key", 0);
+    if (r->pairCount != 3 || r->firstSeenMs != 10 || r->lastSeenMs != 30) fail("merge counters", 0);
+}
+
+int main(int argc, char** argv) {
+    const size_t entries = argc > 1 ? (size_t)atol(argv[1]) : 10000;
+    const int rounds = argc > 2 ? atoi(argv[2]) : 20;
+    if (entries == 0 || entries > CAPACITY) {
+        fprintf(stderr, "entries must be 1..%u\n", CAPACITY);
+        return 1;
+    }
+
+    std::mt19937 rng(12345);
+    std::vector<Identity> ids(entries * 2);      // second half: never inserted
+    for (size_t i = 0; i < ids.size(); i++) {
+        for (int b = 0; b < 6; b++) ids[i].addr[b] = (uint8_t)rng();
+        for (int b = 0; b < 16; b++) ids[i].irk[b] = (uint8_t)rng();
+        ids[i].addr[5] = (uint8_t)(i);            // keep addresses unique
+        ids[i].addr[4] = (uint8_t)(i >> 8);
+        ids[i].addr[3] = (uint8_t)(i >> 16);
+    }
+
+    checkMerge(ids[entries], ids[entries + 1 < ids.size() ? entries + 1 : 0]);
+
+    static irkstore::Store<CAPACITY> store;
+    double insertNs = 0, hitAddrNs = 0, hitIrkNs = 0, missNs = 0, repeatNs = 0, removeNs = 0, pageNs = 0;
+
+    for (int round = 0; round < rounds; round++) {
+        store.clear();
+
+        Clock::time_point t = Clock::now();
+        for (size_t i = 0; i < entries; i++) {
+            if (store.upsert(ids[i].addr, 0, ids[i].irk, 1) != irkstore::INSERTED) fail("insert", i);
+        }
+        insertNs += nsPerOp(t, entries);
+
+        t = Clock::now();
+        for (size_t i = 0; i < entries; i++) {
+            if (!store.findByAddr(ids[i].addr)) fail("lookup addr", i);
+        }
+        hitAddrNs += nsPerOp(t, entries);
+
+        t = Clock::now();
+        for (size_t i = 0; i < entries; i++) {
+            if (!store.findByIrk(ids[i].irk)) fail("lookup irk", i);
+        }
+        hitIrkNs += nsPerOp(t, entries);
+
+        t = Clock::now();
+        for (size_t i = entries; i < ids.size(); i++) {
+            if (store.findByAddr(ids[i].addr)) fail("miss", i);
+        }
+        missNs += nsPerOp(t, entries);
+
+        // Same phone pairing again after a reset
+        t = Clock::now();
+        for (size_t i = 0; i < entries; i++) {
+            if (store.upsert(ids[i].addr, 0, ids[i].irk, 2) != irkstore::UPDATED) fail("repeat", i);
+        }
+        repeatNs += nsPerOp(t, entries);
+        if (store.size() != entries) fail("duplicate records", store.size());
+
+        t = Clock::now();
+        for (size_t i = 0; i < entries; i += 2) {
+            if (!store.remove(ids[i].addr)) fail("remove", i);
+        }
+        removeNs += nsPerOp(t, (entries + 1) / 2);
+        for (size_t i = 1; i < entries; i += 2) {
+            const irkstore::Record* r = store.findByIrk(ids[i].irk);
+            if (!r || r->pairCount != 2) fail("lookup after remove", i);
+        }
+
+        // Walk the remaining records page by page; every record must come
+        // back exactly once, in ascending address order
+        irkstore::Record page[PAGE_SIZE];
+        uint8_t cursor[6];
+        size_t walked = 0;
+        bool more = true;
+        t = Clock::now();
+        for (bool first = true; more; first = false) {
+            uint16_t n = store.page(first ? NULL : cursor, page, PAGE_SIZE, &more);
+            for (uint16_t k = 0; k < n; k++) {
+                if ((!first || k > 0) && memcmp(page[k].addr, cursor, 6) <= 0) fail("page order", walked);
+                memcpy(cursor, page[k].addr, 6);
+                walked++;
+            }
+            if (more && n != PAGE_SIZE) fail("short page", walked);
+        }
+        pageNs += nsPerOp(t, walked ? walked : 1);
+        if (walked != store.size()) fail("page walk", walked);
+    }
+
+    printf("entries=%zu capacity=%u rounds=%d record=%zuB store=%zuB\n",
+           entries, CAPACITY, rounds, sizeof(irkstore::Record), sizeof(store));
+    printf("insert        %7.1f ns/op\n", insertNs / rounds);
+    printf("lookup addr   %7.1f ns/op\n", hitAddrNs / rounds);
+    printf("lookup irk    %7.1f ns/op\n", hitIrkNs / rounds);
+    printf("lookup miss   %7.1f ns/op\n", missNs / rounds);
+    printf("repeat pair   %7.1f ns/op\n", repeatNs / rounds);
+    printf("remove        %7.1f ns/op\n", removeNs / rounds);
+    printf("page walk     %7.1f ns/record (%u per page)\n", pageNs / rounds, PAGE_SIZE);
+    return 0;
+}
@@ -0,0 +1,256 @@
+/*
+ * log_ring_bench - log shipper ring and wire format checks and timings
+ *
+ * Checks drop accounting and sequence numbers of include/log_ring.h and the
+ * exact syslog / JSON output for known lines, then times push + pop +
+ * format per record. With --udp it also plays the shipper's send loop
+ * against a collector (tools/log-listen, netcat, rsyslog): records are
+ * offered at --rate per second, the ring is drained every --flush-ms, JSON
+ * lines are packed into datagrams and syslog goes one message per datagram.
+ *
+ *   log_ring_bench [--records N] [--format syslog|json]
+ *                  [--udp HOST:PORT --rate EVENTS_PER_S --seconds S --flush-ms MS]
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <thread>
+
+#include "log_ring.h"
+
+// Firmware defaults (LOG_SHIP_RING_SLOTS, LOG_SHIP_LINE_MAX, LOG_SHIP_DATAGRAM_MAX)
+static const uint16_t SLOTS = 64;
+static const uint16_t LINE_MAX = 128;
+static const size_t DATAGRAM_MAX = 1400;
+static const uint8_t FACILITY_LOCAL0 = 16;
+
+typedef logring::Ring<SLOTS, LINE_MAX> Ring;
+typedef std::chrono::steady_clock Clock;
+
+static void fail(const char* what, const char* got) {
+    fprintf(stderr, "FAIL: %s\n  got: %s\n", what, got);
+    exit(1);
+}
+
+static bool push(Ring& ring, uint32_t ms, uint8_t kind, const char* text) {
+    return ring.push(ms, kind, text, strlen(text));
+}
+
+static void checkFormats() {
+    static Ring ring;
+    Ring::Entry e;
+    char out[DATAGRAM_MAX];
+
+    push(ring, 12345, logring::KIND_LOG, "\033[0;32mI (12345) GATTS: Pairing \"done\"\n\033[0m");
+    ring.pop(e);
+    formatSyslog(e, "esp32-irk-finder", FACILITY_LOCAL0, out, sizeof(out));
+    if (strcmp(out, "<134>1 - esp32-irk-finder irk-finder - LOG [meta sequenceId=\"1\" sysUpTime=\"1234\"] "
+                    "GATTS: Pairing \"done\"") != 0) fail("syslog log line", out);
+    formatJson(e, "esp32-irk-finder", out, sizeof(out));
+    if (strcmp(out, "{\"seq\":1,\"ms\":12345,\"host\":\"esp32-irk-finder\",\"type\":\"log\",\"level\":\"I\","
+                    "\"tag\":\"GATTS\",\"msg\":\"Pairing \\\"done\\\"\"}\n") != 0) fail("json log line", out);
+
+    push(ring, 500, logring::KIND_LOG, "E (500) wifi:bcn_timeout: ap lost\n");
+    ring.pop(e);
+    formatSyslog(e, "h", FACILITY_LOCAL0, out, sizeof(out));
+    if (strcmp(out, "<131>1 - h irk-finder - LOG [meta sequenceId=\"2\" sysUpTime=\"50\"] wifi:bcn_timeout: ap lost") != 0)
+        fail("syslog error line", out);
+
+    push(ring, 0, logring::KIND_LOG, "plain text");
+    ring.pop(e);
+    formatJson(e, "h", out, sizeof(out));
+    if (strcmp(out, "{\"seq\":3,\"ms\":0,\"host\":\"h\",\"type\":\"log\",\"level\":\"I\",\"tag\":\"-\","
+                    "\"msg\":\"plain text\"}\n") != 0) fail("json unparsed line", out);
+
+    push(ring, 7, logring::KIND_IRK, "C4:5A:11:22:33:44 112233445566778899aabbccddeeff00 key_exchange");
+    ring.pop(e);
+    formatJson(e, "h", out, sizeof(out));
+    if (strcmp(out, "{\"seq\":4,\"ms\":7,\"host\":\"h\",\"type\":\"irk\",\"mac\":\"C4:5A:11:22:33:44\","
+                    "\"irk\":\"112233445566778899aabbccddeeff00\",\"source\":\"key_exchange\"}\n") != 0)
+        fail("json irk", out);
+    formatSyslog(e, "h", FACILITY_LOCAL0, out, sizeof(out));
+    if (strcmp(out, "<134>1 - h irk-finder - IRK [meta sequenceId=\"4\" sysUpTime=\"0\"] "
+                    "C4:5A:11:22:33:44 112233445566778899aabbccddeeff00 key_exchange") != 0)
+        fail("syslog irk", out);
+
+    push(ring, 9, logring::KIND_DROP, "17");
+    ring.pop(e);
+    formatJson(e, "h", out, sizeof(out));
+    if (strcmp(out, "{\"seq\":5,\"ms\":9,\"host\":\"h\",\"type\":\"drop\",\"count\":17}\n") != 0)
+        fail("json drop", out);
+}
+
+static void checkDrops() {
+    static Ring ring;
+    for (int i = 0; i < SLOTS + 10; i++) push(ring, i, logring::KIND_LOG, "x");
+    char got[64];
+    snprintf(got, sizeof(got), "size %u dropped %u", ring.size(), ring.dropped());
+    if (ring.size() != SLOTS || ring.dropped() != 10) fail("drop count", got);
+
+    // Dropped records still consume sequence numbers
+    Ring::Entry e;
+    while (ring.pop(e)) {}
+    push(ring, 0, logring::KIND_LOG, "after");
+    ring.pop(e);
+    snprintf(got, sizeof(got), "seq %u", e.seq);
+    if (e.seq != SLOTS + 11) fail("sequence after drops", got);
+
+    // Long lines are truncated, not rejected
+    char longLine[300];
+    memset(longLine, 'a', sizeof(longLine));
+    ring.push(0, logring::KIND_LOG, longLine, sizeof(longLine));
+    ring.pop(e);
+    if (e.len != LINE_MAX - 1 || e.text[LINE_MAX - 1] != '\0') fail("truncation", e.text);
+}
+
+static size_t format(const Ring::Entry& e, bool json, char* out, size_t cap) {
+    return json ? formatJson(e, "esp32-irk-finder", out, cap)
+                : formatSyslog(e, "esp32-irk-finder", FACILITY_LOCAL0, out, cap);
+}
+
+static void timeFormat(size_t records, bool json) {
+    static Ring ring;
+    Ring::Entry e;
+    char out[DATAGRAM_MAX];
+    char line[96];
+    size_t bytes = 0;
+
+    Clock::time_point t = Clock::now();
+    for (size_t i = 0; i < records; i++) {
+        int n = snprintf(line, sizeof(line), "I (%zu) BENCH: record %zu of the throughput run\n", i, i);
+        ring.push((uint32_t)i, logring::KIND_LOG, line, (size_t)n);
+        ring.pop(e);
+        bytes += format(e, json, out, sizeof(out));
+    }
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - t).count() / records;
+    printf("%-6s push+pop+format %7.1f ns/record, %.0f bytes/record\n", json ? "json" : "syslog", ns,
+           (double)bytes / records);
+}
+
+// The firmware sender loop against a real UDP collector
+static int sendLoop(const char* target, bool json, unsigned rate, unsigned seconds, unsigned flushMs) {
+    char host[64];
+    strncpy(host, target, sizeof(host) - 1);
+    host[sizeof(host) - 1] = '\0';
+    char* colon = strrchr(host, ':');
+    if (!colon) {
+        fprintf(stderr, "--udp wants HOST:PORT\n");
+        return 1;
+    }
+    *colon = '\0';
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)atoi(colon + 1));
+    if (inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
+        fprintf(stderr, "--udp wants an IPv4 address\n");
+        return 1;
+    }
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+
+    static Ring ring;
+    Ring::Entry e;
+    char datagram[DATAGRAM_MAX];
+    char out[DATAGRAM_MAX];
+    char line[96];
+    uint64_t offered = 0, sent = 0, datagrams = 0, sendErrors = 0;
+    uint32_t reportedDrops = 0;
+
+    Clock::time_point start = Clock::now();
+    for (unsigned tick = 0; tick * flushMs < seconds * 1000u; tick++) {
+        // Producers: the records due in this flush interval
+        uint64_t due = (uint64_t)rate * (tick + 1) * flushMs / 1000;
+        for (; offered < due; offered++) {
+            uint32_t ms = (uint32_t)(offered * 1000 / (rate ? rate : 1));
+            int n = snprintf(line, sizeof(line), "I (%u) BENCH: record %llu\n", ms, (unsigned long long)offered);
+            ring.push(ms, logring::KIND_LOG, line, (size_t)n);
+        }
+
+        // Sender: report drops, then drain
+        if (ring.dropped() != reportedDrops) {
+            char count[12];
+            snprintf(count, sizeof(count), "%u", ring.dropped() - reportedDrops);
+            reportedDrops = ring.dropped();
+            Ring::Entry drop = {};
+            drop.kind = logring::KIND_DROP;
+            drop.len = (uint8_t)strlen(count);
+            memcpy(drop.text, count, drop.len + 1);
+            size_t n = format(drop, json, out, sizeof(out));
+            sendto(sock, out, n, 0, (sockaddr*)&addr, sizeof(addr));
+        }
+        size_t fill = 0;
+        while (ring.pop(e)) {
+            size_t n = format(e, json, out, sizeof(out));
+            if (n == 0) continue;
+            if (json && fill + n <= sizeof(datagram)) {
+                memcpy(datagram + fill, out, n);
+                fill += n;
+                sent++;
+                continue;
+            }
+            const char* payload = json ? datagram : out;
+            size_t len = json ? fill : n;
+            if (sendto(sock, payload, len, 0, (sockaddr*)&addr, sizeof(addr)) < 0) sendErrors++;
+            datagrams++;
+            if (json) {
+                memcpy(datagram, out, n);
+                fill = n;
+            }
+            sent++;
+        }
+        if (json && fill > 0) {
+            if (sendto(sock, datagram, fill, 0, (sockaddr*)&addr, sizeof(addr)) < 0) sendErrors++;
+            datagrams++;
+        }
+
+        std::this_thread::sleep_until(start + std::chrono::milliseconds((tick + 1) * flushMs));
+    }
+    close(sock);
+
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    printf("offered %llu, sent %llu in %llu datagrams, dropped %u, send errors %llu\n",
+           (unsigned long long)offered, (unsigned long long)sent, (unsigned long long)datagrams,
+           ring.dropped(), (unsigned long long)sendErrors);
+    printf("%.0f events/s sent over %.1f s\n", sent / elapsed, elapsed);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    size_t records = 200000;
+    bool json = false;
+    const char* udp = NULL;
+    unsigned rate = 500, seconds = 5, flushMs = 100;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--records") && i + 1 < argc) records = (size_t)atol(argv[++i]);
+        else if (!strcmp(argv[i], "--format") && i + 1 < argc) json = !strcmp(argv[++i], "json");
+        else if (!strcmp(argv[i], "--udp") && i + 1 < argc) udp = argv[++i];
+        else if (!strcmp(argv[i], "--rate") && i + 1 < argc) rate = (unsigned)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = (unsigned)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--flush-ms") && i + 1 < argc) flushMs = (unsigned)atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [--records N] [--format syslog|json] "
+                            "[--udp HOST:PORT --rate N --seconds S --flush-ms MS]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (records == 0 || flushMs == 0) {
+        fprintf(stderr, "--records and --flush-ms must be positive\n");
+        return 1;
+    }
+
+    checkFormats();
+    checkDrops();
+    printf("formats and drop accounting OK (%u slots, %u-byte lines, %zu-byte slot)\n", SLOTS, LINE_MAX,
+           sizeof(Ring::Entry));
+
+    if (udp) return sendLoop(udp, json, rate, seconds, flushMs);
+    timeFormat(records, false);
+    timeFormat(records, true);
+    return 0;
+}
@@ -0,0 +1,373 @@
+/*
+ * http_bench - concurrent HTTP load generator for the IRK Finder web API
+ *
+ * Drives N keep-alive clients round-robin over a set of routes for a fixed
+ * duration, samples device heap through /api/debug/heap, and writes per-route
+ * throughput, latency percentiles and error rates as JSON. Snapshot routes
+ * (e.g. /api/pairing/stats) are fetched before and after the run and copied
+ * into the results, so device-side figures taken under load sit next to them.
+ *
+ *   http_bench --host 192.168.1.50 --clients 8 --duration 30 --out results.json
+ */
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options {
+    std::string host = "esp32-irk-finder.local";
+    int port = 80;
+    int clients = 4;
+    int duration = 10;
+    int timeoutMs = 5000;
+    std::vector<std::string> routes;
+    std::vector<std::string> snapshots;
+    std::string heapRoute = "/api/debug/heap";
+    std::string out = "http_bench.json";
+    std::string label;
+};
+
+struct RouteStats {
+    std::vector<double> latencyMs;
+    uint64_t ok = 0;
+    uint64_t bytes = 0;
+    std::map<int, uint64_t> statusCodes;
+    uint64_t errors = 0;        // connect / timeout / malformed response
+};
+
+struct HeapSample {
+    long freeHeap = -1;
+    long minFreeHeap = -1;
+    long maxAllocHeap = -1;
+};
+
+static std::mutex statsMutex;
+static std::map<std::string, RouteStats> routeStats;
+static std::atomic<bool> running(true);
+
+static int connectTo(const Options& opt) {
+    struct addrinfo hints, *res = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    char port[8];
+    snprintf(port, sizeof(port), "%d", opt.port);
+    if (getaddrinfo(opt.host.c_str(), port, &hints, &res) != 0 || !res) return -1;
+
+    int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (fd >= 0) {
+        struct timeval tv;
+        tv.tv_sec = opt.timeoutMs / 1000;
+        tv.tv_usec = (opt.timeoutMs % 1000) * 1000;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (connect(fd, res->ai_addr, res->ai_addrlen) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+// Read one HTTP/1.1 response. Returns the status code, or -1 on error.
+// keepAlive is cleared when the server will close the connection. The body
+// is copied to body when one is given.
+static int readResponse(int fd, std::string& buf, size_t& bodyBytes, bool& keepAlive, std::string* body) {
+    size_t headerEnd;
+    while ((headerEnd = buf.find("\r\n\r\n")) == std::string::npos) {
+        char tmp[4096];
+        ssize_t n = recv(fd, tmp, sizeof(tmp), 0);
+        if (n <= 0) return -1;
+        buf.append(tmp, (size_t)n);
+    }
+
+    std::string head = buf.substr(0, headerEnd);
+    for (size_t i = 0; i < head.size(); i++) head[i] = (char)tolower((unsigned char)head[i]);
+    int status = 0;
+    if (sscanf(head.c_str(), "http/1.%*d %d", &status) != 1) return -1;
+
+    keepAlive = head.find("connection: close") == std::string::npos;
+    long contentLength = -1;
+    size_t cl = head.find("content-length:");
+    if (cl != std::string::npos) contentLength = atol(head.c_str() + cl + 15);
+    bool chunked = head.find("transfer-encoding: chunked") != std::string::npos;
+
+    buf.erase(0, headerEnd + 4);
+
+    if (chunked) {
+        bodyBytes = 0;
+        for (;;) {
+            size_t lineEnd;
+            while ((lineEnd = buf.find("\r\n")) == std::string::npos) {
+                char tmp[4096];
+                ssize_t n = recv(fd, tmp, sizeof(tmp), 0);
+                if (n <= 0) return -1;
+                buf.append(tmp, (size_t)n);
+            }
+            size_t size = strtoul(buf.c_str(), NULL, 16);
+            while (buf.size() < lineEnd + 2 + size + 2) {
+                char tmp[4096];
+                ssize_t n = recv(fd, tmp, sizeof(tmp), 0);
+                if (n <= 0) return -1;
+                buf.append(tmp, (size_t)n);
+            }
+            if (body) body->append(buf, lineEnd + 2, size);
+            buf.erase(0, lineEnd + 2 + size + 2);
+            bodyBytes += size;
+            if (size == 0) return status;
+        }
+    }
+
+    if (contentLength >= 0) {
+        while (buf.size() < (size_t)contentLength) {
+            char tmp[4096];
+            ssize_t n = recv(fd, tmp, sizeof(tmp), 0);
+            if (n <= 0) return -1;
+            buf.append(tmp, (size_t)n);
+        }
+        bodyBytes = (size_t)contentLength;
+        if (body) body->assign(buf, 0, (size_t)contentLength);
+        buf.erase(0, (size_t)contentLength);
+        return status;
+    }
+
+    // No length: body runs until the server closes
+    for (;;) {
+        char tmp[4096];
+        ssize_t n = recv(fd, tmp, sizeof(tmp), 0);
+        if (n <= 0) break;
+        buf.append(tmp, (size_t)n);
+    }
+    bodyBytes = buf.size();
+    if (body) body->swap(buf);
+    buf.clear();
+    keepAlive = false;
+    return status;
+}
+
+static int request(const Options& opt, int& fd, std::string& buf, const std::string& route,
+                   std::string* body, size_t& bodyBytes) {
+    if (fd < 0) {
+        fd = connectTo(opt);
+        buf.clear();
+        if (fd < 0) return -1;
+    }
+
+    std::string req = "GET " + route + " HTTP/1.1\r\nHost: " + opt.host +
+                      "\r\nConnection: keep-alive\r\n\r\n";
+    if (send(fd, req.data(), req.size(), MSG_NOSIGNAL) != (ssize_t)req.size()) {
+        close(fd);
+        fd = -1;
+        return -1;
+    }
+
+    bool keepAlive = true;
+    int status = readResponse(fd, buf, bodyBytes, keepAlive, body);
+    if (status < 0 || !keepAlive) {
+        close(fd);
+        fd = -1;
+    }
+    return status;
+}
+
+static void clientLoop(const Options& opt, int id) {
+    int fd = -1;
+    std::string buf;
+    size_t next = (size_t)id;
+
+    while (running) {
+        const std::string& route = opt.routes[next++ % opt.routes.size()];
+        size_t bodyBytes = 0;
+
+        Clock::time_point start = Clock::now();
+        int status = request(opt, fd, buf, route, NULL, bodyBytes);
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lock(statsMutex);
+        RouteStats& rs = routeStats[route];
+        if (status < 0) {
+            rs.errors++;
+            continue;
+        }
+        rs.statusCodes[status]++;
+        if (status >= 200 && status < 300) {
+            rs.ok++;
+            rs.bytes += bodyBytes;
+            rs.latencyMs.push_back(ms);
+        }
+    }
+    if (fd >= 0) close(fd);
+}
+
+static long jsonNumber(const std::string& json, const char* key) {
+    std::string k = std::string("\"") + key + "\":";
+    size_t p = json.find(k);
+    return p == std::string::npos ? -1 : atol(json.c_str() + p + k.size());
+}
+
+static void heapLoop(const Options& opt, HeapSample& lowest, int& samples) {
+    int fd = -1;
+    std::string buf;
+
+    while (running) {
+        std::string body;
+        size_t bodyBytes = 0;
+        if (request(opt, fd, buf, opt.heapRoute, &body, bodyBytes) == 200) {
+            long freeHeap = jsonNumber(body, "freeHeap");
+            long minFree = jsonNumber(body, "minFreeHeap");
+            long maxAlloc = jsonNumber(body, "maxAllocHeap");
+            if (freeHeap >= 0 && (lowest.freeHeap < 0 || freeHeap < lowest.freeHeap)) lowest.freeHeap = freeHeap;
+            if (minFree >= 0 && (lowest.minFreeHeap < 0 || minFree < lowest.minFreeHeap)) lowest.minFreeHeap = minFree;
+            if (maxAlloc >= 0 && (lowest.maxAllocHeap < 0 || maxAlloc < lowest.maxAllocHeap)) lowest.maxAllocHeap = maxAlloc;
+            samples++;
+        }
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+    if (fd >= 0) close(fd);
+}
+
+// One GET on a fresh connection; the body if it is a 200, else null
+static std::string snapshot(const Options& opt, const std::string& route) {
+    int fd = -1;
+    std::string buf, body;
+    size_t bodyBytes = 0;
+    int status = request(opt, fd, buf, route, &body, bodyBytes);
+    if (fd >= 0) close(fd);
+    while (!body.empty() && isspace((unsigned char)body[body.size() - 1])) body.erase(body.size() - 1);
+    return status == 200 && !body.empty() ? body : "null";
+}
+
+static double percentile(std::vector<double>& v, double p) {
+    if (v.empty()) return 0;
+    size_t idx = (size_t)(p * (v.size() - 1) + 0.5);
+    std::nth_element(v.begin(), v.begin() + idx, v.end());
+    return v[idx];
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        std::string v = i + 1 < argc ? argv[i + 1] : "";
+        if (a == "--host") { opt.host = v; i++; }
+        else if (a == "--port") { opt.port = atoi(v.c_str()); i++; }
+        else if (a == "--clients") { opt.clients = atoi(v.c_str()); i++; }
+        else if (a == "--duration") { opt.duration = atoi(v.c_str()); i++; }
+        else if (a == "--timeout") { opt.timeoutMs = atoi(v.c_str()); i++; }
+        else if (a == "--route") { opt.routes.push_back(v); i++; }
+        else if (a == "--heap-route") { opt.heapRoute = v; i++; }
+        else if (a == "--snapshot") { opt.snapshots.push_back(v); i++; }
+        else if (a == "--out") { opt.out = v; i++; }
+        else if (a == "--label") { opt.label = v; i++; }
+        else {
+            fprintf(stderr,
+                    "usage: %s [--host H] [--port P] [--clients N] [--duration S] [--timeout MS]\n"
+                    "          [--route /path]... [--heap-route /path|''] [--snapshot /path]...\n"
+                    "          [--label TEXT] [--out FILE]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (opt.routes.empty()) {
+        opt.routes = {"/", "/api/status", "/api/wifi/status", "/favicon.svg", "/wifi"};
+    }
+
+    HeapSample lowest;
+    int heapSamples = 0;
+
+    std::vector<std::string> before;
+    for (size_t i = 0; i < opt.snapshots.size(); i++) before.push_back(snapshot(opt, opt.snapshots[i]));
+
+    std::vector<std::thread> threads;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < opt.clients; i++) threads.emplace_back(clientLoop, std::cref(opt), i);
+    std::thread heapThread;
+    if (!opt.heapRoute.empty()) heapThread = std::thread(heapLoop, std::cref(opt), std::ref(lowest), std::ref(heapSamples));
+
+    std::this_thread::sleep_for(std::chrono::seconds(opt.duration));
+    running = false;
+    for (size_t i = 0; i < threads.size(); i++) threads[i].join();
+    if (heapThread.joinable()) heapThread.join();
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<std::string> after;
+    for (size_t i = 0; i < opt.snapshots.size(); i++) after.push_back(snapshot(opt, opt.snapshots[i]));
+
+    FILE* f = fopen(opt.out.c_str(), "w");
+    if (!f) {
+        perror(opt.out.c_str());
+        return 1;
+    }
+    fprintf(f, "{\n  \"label\": \"%s\",\n  \"target\": \"%s:%d\",\n  \"clients\": %d,\n  \"duration_s\": %.3f,\n",
+            opt.label.c_str(), opt.host.c_str(), opt.port, opt.clients, elapsed);
+    fprintf(f, "  \"device\": {\"samples\": %d, \"free_heap_min\": %ld, \"min_free_heap\": %ld, \"max_alloc_heap_min\": %ld},\n",
+            heapSamples, lowest.freeHeap, lowest.minFreeHeap, lowest.maxAllocHeap);
+    if (!opt.snapshots.empty()) {
+        fprintf(f, "  \"snapshots\": {\n");
+        for (size_t i = 0; i < opt.snapshots.size(); i++) {
+            fprintf(f, "    \"%s\": {\"before\": %s, \"after\": %s}%s\n", opt.snapshots[i].c_str(),
+                    before[i].c_str(), after[i].c_str(), i + 1 < opt.snapshots.size() ? "," : "");
+        }
+        fprintf(f, "  },\n");
+    }
+    fprintf(f, "  \"routes\": {\n");
+
+    printf("%-20s %8s %8s %8s %8s %8s %8s\n", "route", "req/s", "ok", "non2xx", "errors", "p50 ms", "p99 ms");
+    size_t n = 0;
+    for (size_t r = 0; r < opt.routes.size(); r++) {
+        RouteStats& rs = routeStats[opt.routes[r]];
+        uint64_t non2xx = 0;
+        for (std::map<int, uint64_t>::iterator it = rs.statusCodes.begin(); it != rs.statusCodes.end(); ++it) {
+            if (it->first < 200 || it->first >= 300) non2xx += it->second;
+        }
+        uint64_t total = rs.ok + non2xx + rs.errors;
+        double p50 = percentile(rs.latencyMs, 0.50);
+        double p99 = percentile(rs.latencyMs, 0.99);
+        double maxMs = rs.latencyMs.empty() ? 0 : *std::max_element(rs.latencyMs.begin(), rs.latencyMs.end());
+
+        fprintf(f, "    \"%s\": {\"requests\": %llu, \"ok\": %llu, \"non_2xx\": %llu, \"errors\": %llu, "
+                   "\"error_rate\": %.4f, \"rps\": %.2f, \"bytes\": %llu, "
+                   "\"p50_ms\": %.2f, \"p99_ms\": %.2f, \"max_ms\": %.2f, \"status\": {",
+                opt.routes[r].c_str(), (unsigned long long)total, (unsigned long long)rs.ok,
+                (unsigned long long)non2xx, (unsigned long long)rs.errors,
+                total ? (double)(total - rs.ok) / total : 0.0, rs.ok / elapsed,
+                (unsigned long long)rs.bytes, p50, p99, maxMs);
+        size_t c = 0;
+        for (std::map<int, uint64_t>::iterator it = rs.statusCodes.begin(); it != rs.statusCodes.end(); ++it) {
+            fprintf(f, "%s\"%d\": %llu", c++ ? ", " : "", it->first, (unsigned long long)it->second);
+        }
+        fprintf(f, "}}%s\n", ++n < opt.routes.size() ? "," : "");
+
+        printf("%-20s %8.1f %8llu %8llu %8llu %8.2f %8.2f\n", opt.routes[r].c_str(), rs.ok / elapsed,
+               (unsigned long long)rs.ok, (unsigned long long)non2xx, (unsigned long long)rs.errors, p50, p99);
+    }
+    fprintf(f, "  }\n}\n");
+    fclose(f);
+
+    printf("device free heap min: %ld  (min_free_heap %ld, %d samples)\n",
+           lowest.freeHeap, lowest.minFreeHeap, heapSamples);
+    printf("results written to %s\n", opt.out.c_str());
+    return 0;
+}
@@ -0,0 +1,86 @@
+/*
+ * irk_dump - print IRKs streamed by an ESP32 IRK Finder over USB serial
+ *
+ *   irk_dump /dev/ttyUSB0 [baud] [reset|list|export|status]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "irk_reader.h"
+
+static void printAddr(const uint8_t* addr) {
+    printf("%02X:%02X:%02X:%02X:%02X:%02X", addr[0], addr[1], addr[2], addr[3], addr[4], addr[5]);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <port> [baud] [reset|list|export|status]\n", argv[0]);
+        return 2;
+    }
+
+    int baud = argc > 2 ? atoi(argv[2]) : 921600;
+    irkreader::SerialPort port;
+    if (!port.open(argv[1], baud)) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    irkreader::Reader reader(port.fd());
+    bool oneShot = false;
+    bool done = false;
+
+    reader.onIrk = [](const irkreader::IrkRecord& rec) {
+        printf("irk ");
+        printAddr(rec.addr);
+        printf(" type=%u ", rec.addrType);
+        for (int i = 0; i < 16; i++) printf("%02x", rec.irk[i]);
+        printf("\n");
+        fflush(stdout);
+    };
+    reader.onBondRemoved = [](const uint8_t* addr) {
+        printf("removed ");
+        printAddr(addr);
+        printf("\n");
+        fflush(stdout);
+    };
+    reader.onBondEntry = [](const irkreader::BondEntry& entry) {
+        printf("bond ");
+        printAddr(entry.addr);
+        printf(" type=%u\n", entry.addrType);
+    };
+    reader.onListEnd = [&](uint8_t count) {
+        printf("end count=%u\n", count);
+        done = oneShot;
+    };
+    reader.onStatus = [&](const irkreader::Status& st) {
+        printf("status uptime=%ums heap=%u bonds=%u irk=%s\n",
+               st.uptimeMs, st.freeHeap, st.bonds, st.irkRetrieved ? "yes" : "no");
+        fflush(stdout);
+        done = done || (oneShot && argc > 3 && strcmp(argv[3], "status") == 0);
+    };
+    reader.onAck = [&](uint8_t command, uint8_t status) {
+        printf("ack cmd=0x%02x status=%u\n", command, status);
+        done = oneShot;
+    };
+
+    if (argc > 3) {
+        const char* cmd = argv[3];
+        uint8_t type = 0;
+        if (strcmp(cmd, "reset") == 0) type = irkframe::CMD_RESET;
+        else if (strcmp(cmd, "list") == 0) type = irkframe::CMD_LIST;
+        else if (strcmp(cmd, "export") == 0) type = irkframe::CMD_EXPORT;
+        else if (strcmp(cmd, "status") == 0) type = irkframe::CMD_STATUS;
+        if (type == 0 || !reader.sendCommand(type)) {
+            fprintf(stderr, "cannot send command '%s'\n", cmd);
+            return 1;
+        }
+        oneShot = true;
+    }
+
+    while (!done && reader.poll(oneShot ? 2000 : 1000)) {
+    }
+
+    return 0;
+}
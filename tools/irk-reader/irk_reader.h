@@ -0,0 +1,203 @@
+#ifndef IRK_READER_H
+#define IRK_READER_H
+
+/*
+ * Host-side reader for the ESP32 IRK Finder serial link (Linux/macOS).
+ *
+ * Header-only; shares the frame codec with the firmware through
+ * include/irk_frame.h. Build with -I<repo>/include.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <functional>
+#include <string>
+
+#include "irk_frame.h"
+
+namespace irkreader {
+
+struct IrkRecord {
+    uint8_t addr[6];
+    uint8_t addrType;
+    uint8_t irk[16];
+};
+
+struct BondEntry {
+    uint8_t addr[6];
+    uint8_t addrType;
+};
+
+struct Status {
+    uint32_t uptimeMs;
+    uint32_t freeHeap;
+    uint8_t bonds;
+    bool irkRetrieved;
+};
+
+inline speed_t baudToSpeed(int baud) {
+    switch (baud) {
+        case 9600: return B9600;
+        case 19200: return B19200;
+        case 38400: return B38400;
+        case 57600: return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+#ifdef B460800
+        case 460800: return B460800;
+#endif
+#ifdef B921600
+        case 921600: return B921600;
+#endif
+        default: return B115200;
+    }
+}
+
+// Raw 8N1 serial port. Also works on a pseudo-terminal.
+class SerialPort {
+public:
+    SerialPort() : fd_(-1) {}
+    ~SerialPort() { close(); }
+
+    SerialPort(const SerialPort&) = delete;
+    SerialPort& operator=(const SerialPort&) = delete;
+
+    bool open(const std::string& path, int baud) {
+        close();
+        fd_ = ::open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if (fd_ < 0) return false;
+
+        struct termios tio;
+        if (tcgetattr(fd_, &tio) != 0) {
+            close();
+            return false;
+        }
+        cfmakeraw(&tio);
+        tio.c_cflag |= CLOCAL | CREAD;
+        cfsetispeed(&tio, baudToSpeed(baud));
+        cfsetospeed(&tio, baudToSpeed(baud));
+        if (tcsetattr(fd_, TCSANOW, &tio) != 0) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+    }
+
+    int fd() const { return fd_; }
+
+private:
+    int fd_;
+};
+
+// Parses frames from a file descriptor and dispatches them to callbacks.
+class Reader {
+public:
+    std::function<void(const IrkRecord&)> onIrk;
+    std::function<void(const uint8_t* addr)> onBondRemoved;
+    std::function<void(const BondEntry&)> onBondEntry;
+    std::function<void(uint8_t count)> onListEnd;
+    std::function<void(const Status&)> onStatus;
+    std::function<void(uint8_t command, uint8_t status)> onAck;
+
+    explicit Reader(int fd) : fd_(fd), bytes_(0) {}
+
+    // Wait up to timeoutMs for data and dispatch every complete frame.
+    // Returns false on a read error or end of stream.
+    bool poll(int timeoutMs) {
+        struct pollfd pfd = {fd_, POLLIN, 0};
+        int r = ::poll(&pfd, 1, timeoutMs);
+        if (r < 0) return errno == EINTR;
+        if (r == 0) return true;
+
+        uint8_t buf[4096];
+        ssize_t n = ::read(fd_, buf, sizeof(buf));
+        if (n < 0) return errno == EAGAIN || errno == EINTR;
+        if (n == 0) return false;
+
+        bytes_ += (uint64_t)n;
+        for (ssize_t i = 0; i < n; i++) {
+            if (parser_.feed(buf[i])) dispatch();
+        }
+        return true;
+    }
+
+    bool sendCommand(uint8_t command) {
+        uint8_t frame[irkframe::MAX_FRAME];
+        size_t len = irkframe::encode(command, NULL, 0, frame, sizeof(frame));
+        return ::write(fd_, frame, len) == (ssize_t)len;
+    }
+
+    uint64_t bytes() const { return bytes_; }
+    uint32_t frames() const { return parser_.frames(); }
+    uint32_t crcErrors() const { return parser_.crcErrors(); }
+
+private:
+    void dispatch() {
+        const uint8_t* p = parser_.payload();
+        size_t len = parser_.length();
+
+        switch (parser_.type()) {
+            case irkframe::EVT_IRK_CAPTURED:
+                if (len >= irkframe::IRK_CAPTURED_SIZE && onIrk) {
+                    IrkRecord rec;
+                    memcpy(rec.addr, p, 6);
+                    rec.addrType = p[6];
+                    memcpy(rec.irk, &p[7], 16);
+                    onIrk(rec);
+                }
+                break;
+
+            case irkframe::EVT_BOND_REMOVED:
+                if (len >= irkframe::BOND_REMOVED_SIZE && onBondRemoved) onBondRemoved(p);
+                break;
+
+            case irkframe::EVT_BOND_ENTRY:
+                if (len >= irkframe::BOND_ENTRY_SIZE && onBondEntry) {
+                    BondEntry entry;
+                    memcpy(entry.addr, p, 6);
+                    entry.addrType = p[6];
+                    onBondEntry(entry);
+                }
+                break;
+
+            case irkframe::EVT_LIST_END:
+                if (len >= 1 && onListEnd) onListEnd(p[0]);
+                break;
+
+            case irkframe::EVT_STATUS:
+                if (len >= irkframe::STATUS_SIZE && onStatus) {
+                    Status st;
+                    st.uptimeMs = irkframe::getU32(&p[0]);
+                    st.freeHeap = irkframe::getU32(&p[4]);
+                    st.bonds = p[8];
+                    st.irkRetrieved = p[9] != 0;
+                    onStatus(st);
+                }
+                break;
+
+            case irkframe::EVT_ACK:
+                if (len >= 2 && onAck) onAck(p[0], p[1]);
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    int fd_;
+    uint64_t bytes_;
+    irkframe::Parser parser_;
+};
+
+}  // namespace irkreader
+
+#endif
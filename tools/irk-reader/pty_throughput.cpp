@@ -0,0 +1,91 @@
+/*
+ * pty_throughput - measure frame decode throughput over a pseudo-terminal
+ *
+ * A writer thread streams IRK frames (interleaved with text, as on the real
+ * device) into the master side of a pty; the Reader decodes them from the
+ * slave side. Linux only.
+ *
+ *   pty_throughput [frames] [baud]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "irk_reader.h"
+
+int main(int argc, char** argv) {
+    const uint32_t frames = argc > 1 ? (uint32_t)atol(argv[1]) : 200000;
+    const int baud = argc > 2 ? atoi(argv[2]) : 921600;
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        perror("posix_openpt");
+        return 1;
+    }
+
+    // Raw mode on the master so the line discipline does not touch the bytes
+    struct termios tio;
+    tcgetattr(master, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(master, TCSANOW, &tio);
+
+    irkreader::SerialPort port;
+    if (!port.open(ptsname(master), baud)) {
+        perror("open slave");
+        return 1;
+    }
+
+    std::vector<uint8_t> chunk;
+    for (uint32_t i = 0; i < 64; i++) {
+        uint8_t payload[irkframe::IRK_CAPTURED_SIZE];
+        for (size_t b = 0; b < sizeof(payload); b++) payload[b] = (uint8_t)(i * 31 + b);
+        uint8_t frame[irkframe::MAX_FRAME];
+        size_t n = irkframe::encode(irkframe::EVT_IRK_CAPTURED, payload, sizeof(payload), frame, sizeof(frame));
+        chunk.insert(chunk.end(), frame, frame + n);
+        if (i % 16 == 0) {
+            const char* text = "I (1234) ESP32_IRK: log line between frames\r\n";
+            chunk.insert(chunk.end(), text, text + strlen(text));
+        }
+    }
+    const uint32_t chunks = (frames + 63) / 64;
+    const uint32_t expected = chunks * 64;
+
+    uint32_t received = 0;
+    irkreader::Reader reader(port.fd());
+    reader.onIrk = [&](const irkreader::IrkRecord&) { received++; };
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::thread writer([&]() {
+        for (uint32_t c = 0; c < chunks; c++) {
+            size_t off = 0;
+            while (off < chunk.size()) {
+                ssize_t w = write(master, chunk.data() + off, chunk.size() - off);
+                if (w > 0) {
+                    off += (size_t)w;
+                } else {
+                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+                }
+            }
+        }
+    });
+
+    while (received < expected) {
+        if (!reader.poll(1000)) break;
+        if (std::chrono::steady_clock::now() - start > std::chrono::seconds(60)) break;
+    }
+    writer.join();
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("frames: %u/%u  crc_errors: %u  bytes: %llu\n",
+           received, expected, reader.crcErrors(), (unsigned long long)reader.bytes());
+    printf("time: %.3f s  %.0f frames/s  %.2f MB/s\n",
+           secs, received / secs, reader.bytes() / secs / 1e6);
+
+    close(master);
+    return received == expected ? 0 : 1;
+}
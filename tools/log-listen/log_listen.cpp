@@ -0,0 +1,170 @@
+/*
+ * log_listen - UDP collector for the log shipper (LOG_SHIP_ENABLED)
+ *
+ * Receives RFC 5424 syslog (one message per datagram) or JSON lines (many
+ * per datagram), counts events per second, and uses the sequence number
+ * every record carries to report records lost between the device ring and
+ * here. Drop records sent by the device are totalled separately.
+ *
+ *   log_listen [--port 5514] [--seconds N] [--print]
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+typedef std::chrono::steady_clock Clock;
+
+static volatile sig_atomic_t stop = 0;
+
+static void onSignal(int) {
+    stop = 1;
+}
+
+struct Totals {
+    unsigned long long events = 0;
+    unsigned long long datagrams = 0;
+    unsigned long long bytes = 0;
+    unsigned long long irks = 0;
+    unsigned long long deviceDrops = 0;     // reported by the device
+    unsigned long long gaps = 0;            // sequence numbers never seen, drops included
+    unsigned long long reordered = 0;
+    unsigned long lastSeq = 0;
+};
+
+// Number after `key` in the record, or 0
+static unsigned long numberAfter(const char* rec, size_t len, const char* key) {
+    size_t keyLen = strlen(key);
+    for (size_t i = 0; i + keyLen < len; i++) {
+        if (memcmp(rec + i, key, keyLen) == 0) return strtoul(rec + i + keyLen, NULL, 10);
+    }
+    return 0;
+}
+
+static bool contains(const char* rec, size_t len, const char* s) {
+    size_t n = strlen(s);
+    for (size_t i = 0; i + n <= len; i++) {
+        if (memcmp(rec + i, s, n) == 0) return true;
+    }
+    return false;
+}
+
+// Gaps the device did not account for as drops were lost on the network
+static unsigned long long lostInTransit(const Totals& t) {
+    return t.gaps > t.deviceDrops ? t.gaps - t.deviceDrops : 0;
+}
+
+static void record(Totals& t, const char* rec, size_t len, bool print) {
+    if (len == 0) return;
+    bool json = rec[0] == '{';
+    unsigned long seq = json ? numberAfter(rec, len, "\"seq\":") : numberAfter(rec, len, "sequenceId=\"");
+
+    if (json ? contains(rec, len, "\"type\":\"drop\"") : contains(rec, len, " DROP ")) {
+        t.deviceDrops += json ? numberAfter(rec, len, "\"count\":") : numberAfter(rec, len, "dropped ");
+    } else {
+        t.events++;
+        if (json ? contains(rec, len, "\"type\":\"irk\"") : contains(rec, len, " IRK ")) t.irks++;
+    }
+
+    // Drop records carry no sequence number of their own
+    if (seq != 0) {
+        if (t.lastSeq != 0 && seq > t.lastSeq + 1) t.gaps += seq - t.lastSeq - 1;
+        if (t.lastSeq != 0 && seq <= t.lastSeq) {
+            t.reordered++;
+        } else {
+            t.lastSeq = seq;
+        }
+    }
+    if (print) printf("%.*s\n", (int)len, rec);
+}
+
+int main(int argc, char** argv) {
+    int port = 5514;
+    int seconds = 0;
+    bool print = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--port") && i + 1 < argc) port = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--print")) print = true;
+        else {
+            fprintf(stderr, "usage: %s [--port 5514] [--seconds N] [--print]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    int rcvbuf = 1 << 20;
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((uint16_t)port);
+    if (bind(sock, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        perror("bind");
+        return 1;
+    }
+    timeval timeout = {0, 200000};
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    signal(SIGINT, onSignal);
+    fprintf(stderr, "listening on udp/%d\n", port);
+
+    Totals t;
+    Clock::time_point first, last, tick;
+    bool started = false;
+    unsigned long long tickEvents = 0;
+    char buf[65536];
+
+    while (!stop) {
+        ssize_t n = recv(sock, buf, sizeof(buf), 0);
+        Clock::time_point now = Clock::now();
+        if (started && seconds > 0 && now - first >= std::chrono::seconds(seconds)) break;
+        if (n <= 0) continue;
+        if (!started) {
+            first = tick = now;
+            started = true;
+        }
+        last = now;
+        t.datagrams++;
+        t.bytes += (unsigned long long)n;
+
+        unsigned long long before = t.events;
+        if (buf[0] == '{') {
+            // JSON lines: one record per line
+            size_t start = 0;
+            for (size_t i = 0; i < (size_t)n; i++) {
+                if (buf[i] == '\n') {
+                    record(t, buf + start, i - start, print);
+                    start = i + 1;
+                }
+            }
+            record(t, buf + start, (size_t)n - start, print);
+        } else {
+            record(t, buf, (size_t)n, print);
+        }
+        tickEvents += t.events - before;
+
+        if (!print && now - tick >= std::chrono::seconds(1)) {
+            double s = std::chrono::duration<double>(now - tick).count();
+            fprintf(stderr, "%6.0f events/s  (total %llu, lost %llu, device dropped %llu)\n", tickEvents / s,
+                    t.events, lostInTransit(t), t.deviceDrops);
+            tick = now;
+            tickEvents = 0;
+        }
+    }
+    close(sock);
+
+    double span = started ? std::chrono::duration<double>(last - first).count() : 0;
+    printf("events %llu (irk %llu) in %llu datagrams, %llu bytes\n", t.events, t.irks, t.datagrams, t.bytes);
+    printf("lost in transit %llu, dropped on device %llu, out of order %llu\n", lostInTransit(t), t.deviceDrops,
+           t.reordered);
+    if (span > 0) printf("%.0f events/s over %.1f s\n", t.events / span, span);
+    return 0;
+}
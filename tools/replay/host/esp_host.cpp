@@ -0,0 +1,248 @@
+/*
+ * Host stand-ins for the firmware's platform APIs (see esp_host.h)
+ */
+
+#include <stdarg.h>
+
+#include <deque>
+#include <vector>
+
+#include "esp_host.h"
+
+HostSerial Serial;
+HostEsp ESP;
+HostCalls host_calls;
+bool host_verbose = false;
+
+static unsigned long nowMs = 0;
+static std::deque<uint8_t> serialIn;
+static void (*serialSink)(const uint8_t* data, size_t n) = NULL;
+static esp_gap_ble_cb_t gapCallback = NULL;
+static esp_gatts_cb_t gattsCallback = NULL;
+
+static std::vector<esp_ble_bond_dev_t> bonds;
+static std::vector<esp_ble_bond_dev_t> pending;
+
+// ---------------------------------------------------------------- Arduino
+
+size_t HostSerial::print(const char* s) {
+    if (host_verbose) fputs(s, stdout);
+    return strlen(s);
+}
+
+size_t HostSerial::println(const char* s) {
+    if (host_verbose) puts(s);
+    return strlen(s) + 1;
+}
+
+size_t HostSerial::printf(const char* fmt, ...) {
+    char buf[256];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    if (host_verbose) fputs(buf, stdout);
+    return n > 0 ? (size_t)n : 0;
+}
+
+size_t HostSerial::write(const uint8_t* data, size_t n) {
+    if (serialSink) serialSink(data, n);
+    return n;
+}
+
+int HostSerial::available() {
+    return (int)serialIn.size();
+}
+
+int HostSerial::read() {
+    if (serialIn.empty()) return -1;
+    int b = serialIn.front();
+    serialIn.pop_front();
+    return b;
+}
+
+unsigned long millis() {
+    return nowMs;
+}
+
+unsigned long micros() {
+    return nowMs * 1000;
+}
+
+void delay(uint32_t ms) {
+    nowMs += ms;
+}
+
+bool btStart() {
+    return true;
+}
+
+void host_log(char level, const char* tag, const char* fmt, ...) {
+    if (!host_verbose || level == 'V') return;
+    va_list ap;
+    va_start(ap, fmt);
+    printf("%c (%s) ", level, tag);
+    vprintf(fmt, ap);
+    putchar('\n');
+    va_end(ap);
+}
+
+int64_t esp_timer_get_time() {
+    return (int64_t)nowMs * 1000;
+}
+
+// Deterministic, so replays do not depend on the run
+void esp_fill_random(void* buf, size_t len) {
+    static uint32_t state = 0x2545F491;
+    uint8_t* p = (uint8_t*)buf;
+    for (size_t i = 0; i < len; i++) {
+        state = state * 1664525u + 1013904223u;
+        p[i] = (uint8_t)(state >> 24);
+    }
+}
+
+// ---------------------------------------------------------------- Bluedroid
+
+esp_err_t esp_bluedroid_init() { return ESP_OK; }
+esp_err_t esp_bluedroid_enable() { return ESP_OK; }
+esp_bluedroid_status_t esp_bluedroid_get_status() { return ESP_BLUEDROID_STATUS_UNINITIALIZED; }
+
+esp_err_t esp_ble_gap_register_callback(esp_gap_ble_cb_t callback) {
+    gapCallback = callback;
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_register_callback(esp_gatts_cb_t callback) {
+    gattsCallback = callback;
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_app_register(uint16_t) { return ESP_OK; }
+esp_err_t esp_ble_gap_set_security_param(esp_ble_sm_param_t, void*, uint8_t) { return ESP_OK; }
+esp_err_t esp_ble_gap_set_device_name(const char*) { return ESP_OK; }
+esp_err_t esp_ble_gap_set_rand_addr(esp_bd_addr_t) { return ESP_OK; }
+esp_err_t esp_ble_gap_config_local_privacy(bool) { return ESP_OK; }
+esp_err_t esp_ble_gap_config_adv_data(esp_ble_adv_data_t*) { return ESP_OK; }
+
+esp_err_t esp_ble_gap_start_advertising(esp_ble_adv_params_t*) {
+    host_calls.advStarts++;
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_security_rsp(esp_bd_addr_t, bool) {
+    host_calls.securityRsps++;
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_confirm_reply(esp_bd_addr_t, bool) {
+    host_calls.securityRsps++;
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_set_encryption(esp_bd_addr_t, esp_ble_sec_act_t) {
+    host_calls.encryptionRequests++;
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_update_conn_params(esp_ble_conn_update_params_t*) {
+    host_calls.connParamRequests++;
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_disconnect(esp_bd_addr_t) {
+    host_calls.disconnects++;
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_create_attr_tab(const esp_gatts_attr_db_t*, esp_gatt_if_t, uint16_t, uint8_t) {
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_start_service(uint16_t) {
+    host_calls.servicesStarted++;
+    return ESP_OK;
+}
+
+int esp_ble_get_bond_device_num() {
+    return (int)bonds.size();
+}
+
+esp_err_t esp_ble_get_bond_device_list(int* dev_num, esp_ble_bond_dev_t* dev_list) {
+    int n = *dev_num < (int)bonds.size() ? *dev_num : (int)bonds.size();
+    for (int i = 0; i < n; i++) dev_list[i] = bonds[i];
+    *dev_num = n;
+    return ESP_OK;
+}
+
+static int findBond(std::vector<esp_ble_bond_dev_t>& list, const uint8_t* peer) {
+    for (size_t i = 0; i < list.size(); i++) {
+        if (memcmp(list[i].bd_addr, peer, 6) == 0) return (int)i;
+    }
+    return -1;
+}
+
+esp_err_t esp_ble_remove_bond_device(esp_bd_addr_t bd_addr) {
+    int i = findBond(bonds, bd_addr);
+    if (i < 0) return ESP_FAIL;
+    bonds.erase(bonds.begin() + i);
+    return ESP_OK;
+}
+
+// ---------------------------------------------------------------- Harness
+
+void host_set_millis(unsigned long ms) {
+    nowMs = ms;
+}
+
+void host_serial_inject(const uint8_t* data, size_t n) {
+    serialIn.insert(serialIn.end(), data, data + n);
+}
+
+void host_set_serial_sink(void (*sink)(const uint8_t* data, size_t n)) {
+    serialSink = sink;
+}
+
+esp_gap_ble_cb_t host_gap_callback() {
+    return gapCallback;
+}
+
+esp_gatts_cb_t host_gatts_callback() {
+    return gattsCallback;
+}
+
+void host_bond_add(const esp_ble_bond_dev_t& dev) {
+    int i = findBond(bonds, dev.bd_addr);
+    if (i >= 0) bonds[i] = dev;
+    else bonds.push_back(dev);
+}
+
+void host_bond_key(const esp_bd_addr_t peer, const esp_ble_key_t& key) {
+    int i = findBond(pending, peer);
+    if (i < 0) {
+        esp_ble_bond_dev_t dev;
+        memset(&dev, 0, sizeof(dev));
+        memcpy(dev.bd_addr, peer, 6);
+        pending.push_back(dev);
+        i = (int)pending.size() - 1;
+    }
+    esp_ble_bond_key_info_t& info = pending[i].bond_key;
+    if (key.key_type == ESP_LE_KEY_PENC) {
+        info.key_mask |= ESP_BLE_ENC_KEY_MASK;
+        info.penc_key = key.p_key_value.penc_key;
+    } else if (key.key_type == ESP_LE_KEY_PID) {
+        info.key_mask |= ESP_BLE_ID_KEY_MASK;
+        info.pid_key = key.p_key_value.pid_key;
+    }
+}
+
+void host_bond_auth_complete(const esp_bd_addr_t peer, bool success) {
+    int i = findBond(pending, peer);
+    if (i < 0) return;
+    if (success) host_bond_add(pending[i]);
+    pending.erase(pending.begin() + i);
+}
+
+void host_bond_clear() {
+    bonds.clear();
+    pending.clear();
+}
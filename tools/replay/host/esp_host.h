@@ -0,0 +1,533 @@
+#ifndef ESP_HOST_H
+#define ESP_HOST_H
+
+/*
+ * Host stand-ins for the Arduino core, FreeRTOS and the Bluedroid API, just
+ * enough to build the headless firmware on a PC for tools/replay. Types and
+ * event numbers follow ESP-IDF 4.4 so handler code compiles unchanged;
+ * functions the firmware calls are recorded in host_calls instead of
+ * talking to a controller.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+// ---------------------------------------------------------------- Arduino
+
+#define PROGMEM
+#define OUTPUT 1
+#define LOW 0
+#define HIGH 1
+
+typedef uint8_t byte;
+
+class String {
+public:
+    String() {}
+    String(const char* s) : s_(s ? s : "") {}
+    String& operator=(const char* s) { s_ = s ? s : ""; return *this; }
+    const char* c_str() const { return s_.c_str(); }
+    size_t length() const { return s_.size(); }
+    bool operator==(const char* s) const { return s_ == s; }
+
+private:
+    std::string s_;
+};
+
+class HostSerial {
+public:
+    void begin(unsigned long) {}
+    size_t print(const char* s);
+    size_t print(const String& s) { return print(s.c_str()); }
+    size_t println(const char* s = "");
+    size_t println(const String& s) { return println(s.c_str()); }
+    size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+    size_t write(const uint8_t* data, size_t n);
+    int available();
+    int read();
+};
+
+class HostEsp {
+public:
+    uint32_t getFreeHeap() { return 200000; }
+    uint32_t getMinFreeHeap() { return 180000; }
+    uint32_t getMaxAllocHeap() { return 110000; }
+    uint32_t getSketchSize() { return 0; }
+    void restart() {}
+};
+
+extern HostSerial Serial;
+extern HostEsp ESP;
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+bool btStart();
+
+// ---------------------------------------------------------------- ESP-IDF
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NVS_NO_FREE_PAGES 0x110d
+#define ESP_ERR_NVS_NEW_VERSION_FOUND 0x1110
+#define ESP_ERROR_CHECK(x) do { esp_err_t err_ = (x); (void)err_; } while (0)
+
+void host_log(char level, const char* tag, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+#define ESP_LOGE(tag, fmt, ...) host_log('E', tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) host_log('W', tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) host_log('I', tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) host_log('D', tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGV(tag, fmt, ...) host_log('V', tag, fmt, ##__VA_ARGS__)
+
+int64_t esp_timer_get_time();
+void esp_fill_random(void* buf, size_t len);
+inline esp_err_t nvs_flash_init() { return ESP_OK; }
+inline esp_err_t nvs_flash_erase() { return ESP_OK; }
+
+// ---------------------------------------------------------------- FreeRTOS
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef void* SemaphoreHandle_t;
+typedef void* QueueHandle_t;
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define portMAX_DELAY 0xFFFFFFFFu
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define tskIDLE_PRIORITY 0
+
+// Handlers run on one thread here, so locks never contend
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { static int m; return &m; }
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t, TickType_t) { return pdTRUE; }
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t) { return pdTRUE; }
+inline QueueHandle_t xQueueCreate(uint32_t, uint32_t) { return NULL; }
+inline BaseType_t xQueueSend(QueueHandle_t, const void*, TickType_t) { return pdFALSE; }
+inline BaseType_t xQueueReceive(QueueHandle_t, void*, TickType_t) { return pdFALSE; }
+inline BaseType_t xTaskCreate(TaskFunction_t, const char*, uint32_t, void*, uint32_t, TaskHandle_t*) { return pdPASS; }
+inline void vTaskDelete(TaskHandle_t) {}
+inline void vTaskDelay(TickType_t) {}
+inline BaseType_t xTaskCreateUniversal(TaskFunction_t, const char*, uint32_t, void*, uint32_t, TaskHandle_t*,
+                                       BaseType_t) { return pdPASS; }
+
+// ---------------------------------------------------------------- Bluedroid
+
+typedef uint8_t esp_bd_addr_t[6];
+typedef uint8_t esp_gatt_if_t;
+typedef uint16_t esp_gatt_perm_t;
+typedef uint8_t esp_gatt_char_prop_t;
+typedef uint8_t esp_ble_key_type_t;
+typedef uint8_t esp_ble_auth_req_t;
+typedef uint8_t esp_ble_io_cap_t;
+typedef uint8_t esp_ble_addr_type_t;
+
+typedef enum {
+    ESP_BT_STATUS_SUCCESS = 0,
+    ESP_BT_STATUS_FAIL,
+} esp_bt_status_t;
+
+typedef enum {
+    ESP_GATT_OK = 0,
+    ESP_GATT_ERROR = 0x85,
+} esp_gatt_status_t;
+
+#define ESP_GATT_IF_NONE 0xff
+#define ESP_GATT_AUTO_RSP 1
+#define ESP_UUID_LEN_16 2
+#define ESP_UUID_LEN_128 16
+
+#define ESP_GATT_UUID_PRI_SERVICE 0x2800
+#define ESP_GATT_UUID_CHAR_DECLARE 0x2803
+#define ESP_GATT_UUID_CHAR_CLIENT_CONFIG 0x2902
+#define ESP_GATT_HEART_RATE_MEAS 0x2A37
+#define ESP_GATT_BODY_SENSOR_LOCATION 0x2A38
+#define ESP_GATT_HEART_RATE_CNTL_POINT 0x2A39
+
+#define ESP_GATT_PERM_READ (1 << 0)
+#define ESP_GATT_PERM_READ_ENCRYPTED (1 << 1)
+#define ESP_GATT_PERM_WRITE (1 << 4)
+#define ESP_GATT_PERM_WRITE_ENCRYPTED (1 << 5)
+#define ESP_GATT_CHAR_PROP_BIT_READ (1 << 1)
+#define ESP_GATT_CHAR_PROP_BIT_WRITE (1 << 3)
+#define ESP_GATT_CHAR_PROP_BIT_NOTIFY (1 << 4)
+
+#define ESP_LE_KEY_NONE 0
+#define ESP_LE_KEY_PENC (1 << 0)
+#define ESP_LE_KEY_PID (1 << 1)
+#define ESP_LE_KEY_PCSRK (1 << 2)
+#define ESP_LE_KEY_PLK (1 << 3)
+#define ESP_LE_KEY_LLK (ESP_LE_KEY_PLK << 4)
+#define ESP_LE_KEY_LENC (ESP_LE_KEY_PENC << 4)
+#define ESP_LE_KEY_LID (ESP_LE_KEY_PID << 4)
+#define ESP_LE_KEY_LCSRK (ESP_LE_KEY_PCSRK << 4)
+
+#define ESP_BLE_ENC_KEY_MASK (1 << 0)
+#define ESP_BLE_ID_KEY_MASK (1 << 1)
+#define ESP_BLE_CSR_KEY_MASK (1 << 2)
+
+#define ESP_LE_AUTH_REQ_SC_MITM_BOND 0x0D
+#define ESP_IO_CAP_NONE 3
+#define ESP_BLE_ONLY_ACCEPT_SPECIFIED_AUTH_DISABLE 0
+
+#define ESP_BLE_ADV_FLAG_GEN_DISC (0x01 << 1)
+#define ESP_BLE_ADV_FLAG_BREDR_NOT_SPT (0x01 << 2)
+
+typedef enum {
+    ESP_BLE_SEC_ENCRYPT = 1,
+    ESP_BLE_SEC_ENCRYPT_NO_MITM,
+    ESP_BLE_SEC_ENCRYPT_MITM,
+} esp_ble_sec_act_t;
+
+typedef enum {
+    ESP_BLE_SM_PASSKEY = 0,
+    ESP_BLE_SM_AUTHEN_REQ_MODE,
+    ESP_BLE_SM_IOCAP_MODE,
+    ESP_BLE_SM_SET_INIT_KEY,
+    ESP_BLE_SM_SET_RSP_KEY,
+    ESP_BLE_SM_MAX_KEY_SIZE,
+    ESP_BLE_SM_MIN_KEY_SIZE,
+    ESP_BLE_SM_SET_STATIC_PASSKEY,
+    ESP_BLE_SM_CLEAR_STATIC_PASSKEY,
+    ESP_BLE_SM_ONLY_ACCEPT_SPECIFIED_SEC_AUTH,
+    ESP_BLE_SM_OOB_SUPPORT,
+    ESP_BLE_APP_ENC_KEY_SIZE,
+} esp_ble_sm_param_t;
+
+typedef enum {
+    ADV_TYPE_IND = 0x00,
+} esp_ble_adv_type_t;
+
+typedef enum {
+    BLE_ADDR_TYPE_PUBLIC = 0x00,
+    BLE_ADDR_TYPE_RANDOM = 0x01,
+} esp_ble_own_addr_type_t;
+
+typedef enum {
+    ADV_CHNL_ALL = 0x07,
+} esp_ble_adv_channel_t;
+
+typedef enum {
+    ADV_FILTER_ALLOW_SCAN_ANY_CON_ANY = 0x00,
+} esp_ble_adv_filter_t;
+
+typedef struct {
+    bool set_scan_rsp;
+    bool include_name;
+    bool include_txpower;
+    int min_interval;
+    int max_interval;
+    int appearance;
+    uint16_t manufacturer_len;
+    uint8_t* p_manufacturer_data;
+    uint16_t service_data_len;
+    uint8_t* p_service_data;
+    uint16_t service_uuid_len;
+    uint8_t* p_service_uuid;
+    uint8_t flag;
+} esp_ble_adv_data_t;
+
+typedef struct {
+    uint16_t adv_int_min;
+    uint16_t adv_int_max;
+    esp_ble_adv_type_t adv_type;
+    esp_ble_own_addr_type_t own_addr_type;
+    esp_bd_addr_t peer_addr;
+    esp_ble_addr_type_t peer_addr_type;
+    esp_ble_adv_channel_t channel_map;
+    esp_ble_adv_filter_t adv_filter_policy;
+} esp_ble_adv_params_t;
+
+typedef struct {
+    esp_bd_addr_t bda;
+    uint16_t min_int;
+    uint16_t max_int;
+    uint16_t latency;
+    uint16_t timeout;
+} esp_ble_conn_update_params_t;
+
+typedef struct {
+    uint16_t len;
+    union {
+        uint16_t uuid16;
+        uint32_t uuid32;
+        uint8_t uuid128[16];
+    } uuid;
+} esp_bt_uuid_t;
+
+typedef struct {
+    esp_bt_uuid_t uuid;
+    uint8_t inst_id;
+} esp_gatt_id_t;
+
+typedef struct {
+    esp_gatt_id_t id;
+    bool is_primary;
+} esp_gatt_srvc_id_t;
+
+typedef struct {
+    uint8_t auto_rsp;
+} esp_attr_control_t;
+
+typedef struct {
+    uint16_t uuid_length;
+    uint8_t* uuid_p;
+    uint16_t perm;
+    uint16_t max_length;
+    uint16_t length;
+    uint8_t* value;
+} esp_attr_desc_t;
+
+typedef struct {
+    esp_attr_control_t attr_control;
+    esp_attr_desc_t att_desc;
+} esp_gatts_attr_db_t;
+
+typedef struct {
+    uint8_t irk[16];
+    esp_ble_addr_type_t addr_type;
+    esp_bd_addr_t static_addr;
+} esp_ble_pid_keys_t;
+
+typedef struct {
+    uint8_t ltk[16];
+    uint8_t rand[8];
+    uint16_t ediv;
+    uint8_t sec_level;
+    uint8_t key_size;
+} esp_ble_penc_keys_t;
+
+typedef union {
+    esp_ble_penc_keys_t penc_key;
+    esp_ble_pid_keys_t pid_key;
+} esp_ble_key_value_t;
+
+typedef struct {
+    uint8_t key_mask;
+    esp_ble_penc_keys_t penc_key;
+    esp_ble_pid_keys_t pid_key;
+} esp_ble_bond_key_info_t;
+
+typedef struct {
+    esp_bd_addr_t bd_addr;
+    esp_ble_bond_key_info_t bond_key;
+} esp_ble_bond_dev_t;
+
+typedef struct {
+    esp_bd_addr_t bd_addr;
+    esp_ble_key_type_t key_type;
+    esp_ble_key_value_t p_key_value;
+} esp_ble_key_t;
+
+typedef struct {
+    esp_bd_addr_t bd_addr;
+    uint32_t passkey;
+} esp_ble_sec_key_notif_t;
+
+typedef struct {
+    esp_bd_addr_t bd_addr;
+} esp_ble_sec_req_t;
+
+typedef struct {
+    esp_bd_addr_t bd_addr;
+    bool key_present;
+    uint8_t key[16];
+    uint8_t key_type;
+    bool success;
+    uint8_t fail_reason;
+    esp_ble_addr_type_t addr_type;
+    uint8_t dev_type;
+    esp_ble_auth_req_t auth_mode;
+} esp_ble_auth_cmpl_t;
+
+typedef union {
+    esp_ble_sec_key_notif_t key_notif;
+    esp_ble_sec_req_t ble_req;
+    esp_ble_key_t ble_key;
+    esp_ble_auth_cmpl_t auth_cmpl;
+} esp_ble_sec_t;
+
+typedef enum {
+    ESP_GAP_BLE_ADV_DATA_SET_COMPLETE_EVT = 0,
+    ESP_GAP_BLE_SCAN_RSP_DATA_SET_COMPLETE_EVT = 1,
+    ESP_GAP_BLE_ADV_START_COMPLETE_EVT = 6,
+    ESP_GAP_BLE_AUTH_CMPL_EVT = 8,
+    ESP_GAP_BLE_KEY_EVT = 9,
+    ESP_GAP_BLE_SEC_REQ_EVT = 10,
+    ESP_GAP_BLE_PASSKEY_NOTIF_EVT = 11,
+    ESP_GAP_BLE_NC_REQ_EVT = 16,
+    ESP_GAP_BLE_ADV_STOP_COMPLETE_EVT = 17,
+    ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT = 20,
+    ESP_GAP_BLE_SET_PKT_LENGTH_COMPLETE_EVT = 21,
+    ESP_GAP_BLE_SET_LOCAL_PRIVACY_COMPLETE_EVT = 22,
+} esp_gap_ble_cb_event_t;
+
+typedef union {
+    struct ble_adv_data_cmpl_evt_param {
+        esp_bt_status_t status;
+    } adv_data_cmpl;
+    struct ble_scan_rsp_data_cmpl_evt_param {
+        esp_bt_status_t status;
+    } scan_rsp_data_cmpl;
+    struct ble_adv_start_cmpl_evt_param {
+        esp_bt_status_t status;
+    } adv_start_cmpl;
+    esp_ble_sec_t ble_security;
+    struct ble_update_conn_params_evt_param {
+        esp_bt_status_t status;
+        esp_bd_addr_t bda;
+        uint16_t min_int;
+        uint16_t max_int;
+        uint16_t latency;
+        uint16_t conn_int;
+        uint16_t timeout;
+    } update_conn_params;
+    struct ble_local_privacy_cmpl_evt_param {
+        esp_bt_status_t status;
+    } local_privacy_cmpl;
+} esp_ble_gap_cb_param_t;
+
+typedef enum {
+    ESP_GATTS_REG_EVT = 0,
+    ESP_GATTS_READ_EVT = 1,
+    ESP_GATTS_WRITE_EVT = 2,
+    ESP_GATTS_MTU_EVT = 4,
+    ESP_GATTS_CONF_EVT = 5,
+    ESP_GATTS_START_EVT = 12,
+    ESP_GATTS_CONNECT_EVT = 14,
+    ESP_GATTS_DISCONNECT_EVT = 15,
+    ESP_GATTS_RESPONSE_EVT = 21,
+    ESP_GATTS_CREAT_ATTR_TAB_EVT = 22,
+} esp_gatts_cb_event_t;
+
+typedef struct {
+    uint16_t interval;
+    uint16_t latency;
+    uint16_t timeout;
+} esp_gatt_conn_params_t;
+
+typedef union {
+    struct gatts_reg_evt_param {
+        esp_gatt_status_t status;
+        uint16_t app_id;
+    } reg;
+    struct gatts_read_evt_param {
+        uint16_t conn_id;
+        uint32_t trans_id;
+        esp_bd_addr_t bda;
+        uint16_t handle;
+        uint16_t offset;
+        bool is_long;
+        bool need_rsp;
+    } read;
+    struct gatts_write_evt_param {
+        uint16_t conn_id;
+        uint32_t trans_id;
+        esp_bd_addr_t bda;
+        uint16_t handle;
+        uint16_t offset;
+        bool need_rsp;
+        bool is_prep;
+        uint16_t len;
+        uint8_t* value;
+    } write;
+    struct gatts_mtu_evt_param {
+        uint16_t conn_id;
+        uint16_t mtu;
+    } mtu;
+    struct gatts_start_evt_param {
+        esp_gatt_status_t status;
+        uint16_t service_handle;
+    } start;
+    struct gatts_connect_evt_param {
+        uint16_t conn_id;
+        uint8_t link_role;
+        esp_bd_addr_t remote_bda;
+        esp_gatt_conn_params_t conn_params;
+    } connect;
+    struct gatts_disconnect_evt_param {
+        uint16_t conn_id;
+        esp_bd_addr_t remote_bda;
+        int reason;
+    } disconnect;
+    struct gatts_add_attr_tab_evt_param {
+        esp_gatt_status_t status;
+        esp_bt_uuid_t svc_uuid;
+        uint8_t svc_inst_id;
+        uint16_t num_handle;
+        uint16_t* handles;
+    } add_attr_tab;
+} esp_ble_gatts_cb_param_t;
+
+typedef void (*esp_gap_ble_cb_t)(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t* param);
+typedef void (*esp_gatts_cb_t)(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t* param);
+
+typedef enum {
+    ESP_BLUEDROID_STATUS_UNINITIALIZED = 0,
+    ESP_BLUEDROID_STATUS_INITIALIZED,
+    ESP_BLUEDROID_STATUS_ENABLED,
+} esp_bluedroid_status_t;
+
+esp_err_t esp_bluedroid_init();
+esp_err_t esp_bluedroid_enable();
+esp_bluedroid_status_t esp_bluedroid_get_status();
+
+esp_err_t esp_ble_gap_register_callback(esp_gap_ble_cb_t callback);
+esp_err_t esp_ble_gatts_register_callback(esp_gatts_cb_t callback);
+esp_err_t esp_ble_gatts_app_register(uint16_t app_id);
+esp_err_t esp_ble_gap_set_security_param(esp_ble_sm_param_t param, void* value, uint8_t len);
+esp_err_t esp_ble_gap_set_device_name(const char* name);
+esp_err_t esp_ble_gap_set_rand_addr(esp_bd_addr_t addr);
+esp_err_t esp_ble_gap_config_local_privacy(bool enable);
+esp_err_t esp_ble_gap_config_adv_data(esp_ble_adv_data_t* adv_data);
+esp_err_t esp_ble_gap_start_advertising(esp_ble_adv_params_t* params);
+esp_err_t esp_ble_gap_security_rsp(esp_bd_addr_t bd_addr, bool accept);
+esp_err_t esp_ble_confirm_reply(esp_bd_addr_t bd_addr, bool accept);
+esp_err_t esp_ble_set_encryption(esp_bd_addr_t bd_addr, esp_ble_sec_act_t sec_act);
+esp_err_t esp_ble_gap_update_conn_params(esp_ble_conn_update_params_t* params);
+esp_err_t esp_ble_gap_disconnect(esp_bd_addr_t remote_device);
+esp_err_t esp_ble_gatts_create_attr_tab(const esp_gatts_attr_db_t* gatts_attr_db, esp_gatt_if_t gatts_if,
+                                        uint16_t max_nb_attr, uint8_t srvc_inst_id);
+esp_err_t esp_ble_gatts_start_service(uint16_t service_handle);
+int esp_ble_get_bond_device_num();
+esp_err_t esp_ble_get_bond_device_list(int* dev_num, esp_ble_bond_dev_t* dev_list);
+esp_err_t esp_ble_remove_bond_device(esp_bd_addr_t bd_addr);
+
+// ---------------------------------------------------------------- Harness
+
+// What the firmware asked of the stack and what the simulated stack holds
+struct HostCalls {
+    uint32_t advStarts;
+    uint32_t encryptionRequests;
+    uint32_t connParamRequests;
+    uint32_t disconnects;
+    uint32_t servicesStarted;
+    uint32_t securityRsps;
+};
+
+extern HostCalls host_calls;
+extern bool host_verbose;
+
+void host_set_millis(unsigned long ms);
+void host_serial_inject(const uint8_t* data, size_t n);
+void host_set_serial_sink(void (*sink)(const uint8_t* data, size_t n));
+esp_gap_ble_cb_t host_gap_callback();
+esp_gatts_cb_t host_gatts_callback();
+
+// Bond store: keys seen in KEY_EVT are kept per peer and committed when
+// authentication succeeds, as Bluedroid writes them to NVS
+void host_bond_add(const esp_ble_bond_dev_t& dev);
+void host_bond_key(const esp_bd_addr_t peer, const esp_ble_key_t& key);
+void host_bond_auth_complete(const esp_bd_addr_t peer, bool success);
+void host_bond_clear();
+
+#endif
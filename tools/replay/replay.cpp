@@ -0,0 +1,468 @@
+/*
+ * ble_replay - feed recorded GAP/GATTS event sequences through the firmware
+ *
+ * Builds the headless firmware (every file in src/, unchanged) against the host
+ * stand-ins in host/, runs setup(), then dispatches each event of a trace
+ * through the gap_event_handler / gatts_event_handler the firmware
+ * registered with the stack. `expect` lines check the resulting IRK state;
+ * handler CPU time is reported per event type.
+ *
+ * Every trace runs in its own process so module state never leaks from one
+ * trace into the next.
+ *
+ *   ble_replay [-v] trace...
+ */
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "host/esp_host.h"
+#include "config.h"
+#include "event_trace.h"
+#include "irk_frame.h"
+#include "irk_index.h"
+#include "irk_publish.h"
+#include "pairing_stats.h"
+
+// Firmware globals and entry points (src/main.cpp)
+extern String currentIRK;
+extern String connectedDeviceMAC;
+extern bool irkRetrieved;
+extern uint16_t currentPairCount;
+void setup();
+void loop();
+
+struct Timing {
+    uint32_t count;
+    uint64_t totalNs;
+    uint64_t maxNs;
+};
+
+struct Replay {
+    const char* path;
+    int line;
+    esp_gatt_if_t gattsIf;
+    irkframe::Parser parser;
+    uint32_t irkFrames;
+    char irkFrameMac[18];       // address of the last IRK frame
+    int listCount;              // count of the last list end frame, -1 before one
+    std::map<std::string, Timing> timings;
+};
+
+static Replay* current = NULL;
+
+static void onSerial(const uint8_t* data, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (!current->parser.feed(data[i])) continue;
+        const uint8_t* p = current->parser.payload();
+        if (current->parser.type() == irkframe::EVT_IRK_CAPTURED) {
+            current->irkFrames++;
+            snprintf(current->irkFrameMac, sizeof(current->irkFrameMac), "%02X:%02X:%02X:%02X:%02X:%02X",
+                     p[0], p[1], p[2], p[3], p[4], p[5]);
+        } else if (current->parser.type() == irkframe::EVT_LIST_END) {
+            current->listCount = p[0];
+        }
+    }
+}
+
+static bool fail(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+static bool fail(const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    fprintf(stderr, "FAIL %s:%d: ", current->path, current->line);
+    vfprintf(stderr, fmt, ap);
+    fputc('\n', stderr);
+    va_end(ap);
+    return false;
+}
+
+// ---------------------------------------------------------------- parsing
+
+typedef std::map<std::string, std::string> Args;
+
+static std::vector<std::string> split(const char* s) {
+    std::vector<std::string> out;
+    while (*s) {
+        while (*s == ' ' || *s == '\t') s++;
+        if (!*s || *s == '#') break;
+        const char* start = s;
+        while (*s && *s != ' ' && *s != '\t') s++;
+        out.push_back(std::string(start, s - start));
+    }
+    return out;
+}
+
+static Args parseArgs(const std::vector<std::string>& tokens, size_t from) {
+    Args args;
+    for (size_t i = from; i < tokens.size(); i++) {
+        size_t eq = tokens[i].find('=');
+        if (eq == std::string::npos) args[tokens[i]] = "";
+        else args[tokens[i].substr(0, eq)] = tokens[i].substr(eq + 1);
+    }
+    return args;
+}
+
+static long num(const Args& args, const char* key, long def) {
+    Args::const_iterator it = args.find(key);
+    return it == args.end() ? def : strtol(it->second.c_str(), NULL, 0);
+}
+
+static bool hexBytes(const std::string& s, uint8_t* out, size_t n) {
+    std::string digits;
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] != ':') digits += s[i];
+    }
+    if (digits.size() != n * 2) return false;
+    for (size_t i = 0; i < n; i++) {
+        char byte[3] = {digits[i * 2], digits[i * 2 + 1], 0};
+        char* end;
+        out[i] = (uint8_t)strtoul(byte, &end, 16);
+        if (*end) return false;
+    }
+    return true;
+}
+
+// Address (AA:BB:CC:DD:EE:FF) or key (32 hex digits); missing means zero
+static bool bytes(const Args& args, const char* key, uint8_t* out, size_t n) {
+    Args::const_iterator it = args.find(key);
+    if (it == args.end()) {
+        memset(out, 0, n);
+        return true;
+    }
+    if (!hexBytes(it->second, out, n)) return fail("bad %s '%s'", key, it->second.c_str());
+    return true;
+}
+
+// Event ids come from the trace recorder's own names (event_trace_name)
+static int eventId(uint8_t source, const std::string& name) {
+    for (int e = 0; e < 64; e++) {
+        TraceEvent ev = {};
+        ev.source = source;
+        ev.event = (uint8_t)e;
+        if (name == event_trace_name(ev)) return e;
+    }
+    return -1;
+}
+
+static uint8_t keyType(const std::string& name) {
+    if (name == "penc") return ESP_LE_KEY_PENC;
+    if (name == "pid") return ESP_LE_KEY_PID;
+    if (name == "pcsrk") return ESP_LE_KEY_PCSRK;
+    if (name == "lenc") return ESP_LE_KEY_LENC;
+    if (name == "lid") return ESP_LE_KEY_LID;
+    if (name == "lcsrk") return ESP_LE_KEY_LCSRK;
+    return (uint8_t)strtoul(name.c_str(), NULL, 0);
+}
+
+// ---------------------------------------------------------------- dispatch
+
+static uint64_t threadNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void record(const std::string& name, uint64_t ns) {
+    Timing& t = current->timings[name];
+    t.count++;
+    t.totalNs += ns;
+    if (ns > t.maxNs) t.maxNs = ns;
+}
+
+static bool gapEvent(const std::string& name, const Args& args) {
+    int id = eventId(TRACE_GAP, name);
+    if (id < 0) return fail("unknown gap event '%s'", name.c_str());
+    esp_gap_ble_cb_event_t event = (esp_gap_ble_cb_event_t)id;
+
+    esp_ble_gap_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    esp_bt_status_t status = (esp_bt_status_t)num(args, "status", 0);
+    esp_ble_sec_t& sec = param.ble_security;
+
+    switch (event) {
+        case ESP_GAP_BLE_ADV_DATA_SET_COMPLETE_EVT:
+            param.adv_data_cmpl.status = status;
+            break;
+        case ESP_GAP_BLE_SCAN_RSP_DATA_SET_COMPLETE_EVT:
+            param.scan_rsp_data_cmpl.status = status;
+            break;
+        case ESP_GAP_BLE_ADV_START_COMPLETE_EVT:
+            param.adv_start_cmpl.status = status;
+            break;
+        case ESP_GAP_BLE_SET_LOCAL_PRIVACY_COMPLETE_EVT:
+            param.local_privacy_cmpl.status = status;
+            break;
+        case ESP_GAP_BLE_PASSKEY_NOTIF_EVT:
+        case ESP_GAP_BLE_NC_REQ_EVT:
+            if (!bytes(args, "peer", sec.key_notif.bd_addr, 6)) return false;
+            sec.key_notif.passkey = (uint32_t)num(args, "passkey", 0);
+            break;
+        case ESP_GAP_BLE_SEC_REQ_EVT:
+            if (!bytes(args, "peer", sec.ble_req.bd_addr, 6)) return false;
+            break;
+        case ESP_GAP_BLE_KEY_EVT: {
+            esp_ble_key_t& key = sec.ble_key;
+            Args::const_iterator type = args.find("type");
+            if (type == args.end()) return fail("key event without type");
+            key.key_type = keyType(type->second);
+            if (!bytes(args, "peer", key.bd_addr, 6)) return false;
+            if (key.key_type == ESP_LE_KEY_PID) {
+                esp_ble_pid_keys_t& pid = key.p_key_value.pid_key;
+                if (!bytes(args, "irk", pid.irk, 16) || !bytes(args, "identity", pid.static_addr, 6)) return false;
+                pid.addr_type = (esp_ble_addr_type_t)num(args, "addr_type", 0);
+            }
+            host_bond_key(key.bd_addr, key);
+            break;
+        }
+        case ESP_GAP_BLE_AUTH_CMPL_EVT: {
+            esp_ble_auth_cmpl_t& auth = sec.auth_cmpl;
+            if (!bytes(args, "peer", auth.bd_addr, 6)) return false;
+            auth.success = num(args, "success", 1) != 0;
+            auth.fail_reason = (uint8_t)num(args, "reason", 0);
+            auth.addr_type = (esp_ble_addr_type_t)num(args, "addr_type", 1);
+            // Bluedroid has written the bond to NVS by the time this arrives
+            host_bond_auth_complete(auth.bd_addr, auth.success);
+            break;
+        }
+        case ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT:
+            param.update_conn_params.status = status;
+            if (!bytes(args, "peer", param.update_conn_params.bda, 6)) return false;
+            param.update_conn_params.conn_int = (uint16_t)num(args, "interval", 24);
+            param.update_conn_params.latency = (uint16_t)num(args, "latency", 0);
+            param.update_conn_params.timeout = (uint16_t)num(args, "timeout", 400);
+            break;
+        default:
+            break;
+    }
+
+    uint64_t t0 = threadNs();
+    host_gap_callback()(event, &param);
+    record(name, threadNs() - t0);
+    return true;
+}
+
+static bool gattsEvent(const std::string& name, const Args& args) {
+    int id = eventId(TRACE_GATTS, name);
+    if (id < 0) return fail("unknown gatts event '%s'", name.c_str());
+    esp_gatts_cb_event_t event = (esp_gatts_cb_event_t)id;
+
+    esp_ble_gatts_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    uint16_t conn = (uint16_t)num(args, "conn", 0);
+    uint16_t handles[32];
+
+    switch (event) {
+        case ESP_GATTS_REG_EVT:
+            param.reg.status = (esp_gatt_status_t)num(args, "status", 0);
+            param.reg.app_id = (uint16_t)num(args, "app_id", 0x55);
+            current->gattsIf = (esp_gatt_if_t)num(args, "if", 3);
+            break;
+        case ESP_GATTS_CONNECT_EVT:
+            param.connect.conn_id = conn;
+            if (!bytes(args, "peer", param.connect.remote_bda, 6)) return false;
+            param.connect.conn_params.interval = (uint16_t)num(args, "interval", 24);
+            param.connect.conn_params.latency = (uint16_t)num(args, "latency", 0);
+            param.connect.conn_params.timeout = (uint16_t)num(args, "timeout", 400);
+            break;
+        case ESP_GATTS_DISCONNECT_EVT:
+            param.disconnect.conn_id = conn;
+            if (!bytes(args, "peer", param.disconnect.remote_bda, 6)) return false;
+            param.disconnect.reason = (int)num(args, "reason", 0x13);
+            break;
+        case ESP_GATTS_MTU_EVT:
+            param.mtu.conn_id = conn;
+            param.mtu.mtu = (uint16_t)num(args, "mtu", 23);
+            break;
+        case ESP_GATTS_READ_EVT:
+            param.read.conn_id = conn;
+            param.read.handle = (uint16_t)num(args, "handle", 0);
+            break;
+        case ESP_GATTS_WRITE_EVT:
+            param.write.conn_id = conn;
+            param.write.handle = (uint16_t)num(args, "handle", 0);
+            break;
+        case ESP_GATTS_CREAT_ATTR_TAB_EVT: {
+            param.add_attr_tab.status = (esp_gatt_status_t)num(args, "status", 0);
+            long n = num(args, "handles", 0);
+            if (n < 0 || n > 32) return fail("handles must be 0..32");
+            for (long i = 0; i < n; i++) handles[i] = (uint16_t)(40 + i);
+            param.add_attr_tab.num_handle = (uint16_t)n;
+            param.add_attr_tab.handles = handles;
+            break;
+        }
+        case ESP_GATTS_START_EVT:
+            param.start.status = (esp_gatt_status_t)num(args, "status", 0);
+            param.start.service_handle = 40;
+            break;
+        default:
+            break;
+    }
+
+    uint64_t t0 = threadNs();
+    host_gatts_callback()(event, current->gattsIf, &param);
+    record(name, threadNs() - t0);
+    return true;
+}
+
+// A bond already in NVS before the trace starts
+static bool bondLine(const Args& args) {
+    esp_ble_bond_dev_t dev;
+    memset(&dev, 0, sizeof(dev));
+    if (!bytes(args, "peer", dev.bd_addr, 6)) return false;
+    dev.bond_key.key_mask = ESP_BLE_ENC_KEY_MASK;
+    if (args.count("irk")) {
+        dev.bond_key.key_mask |= ESP_BLE_ID_KEY_MASK;
+        if (!bytes(args, "irk", dev.bond_key.pid_key.irk, 16)) return false;
+        if (!bytes(args, "identity", dev.bond_key.pid_key.static_addr, 6)) return false;
+        dev.bond_key.pid_key.addr_type = (esp_ble_addr_type_t)num(args, "addr_type", 0);
+    }
+    host_bond_add(dev);
+    return true;
+}
+
+// Let loop() run, 10 ms per iteration as on the device
+static void waitMs(long ms) {
+    unsigned long end = millis() + (unsigned long)ms;
+    while ((long)(millis() - end) < 0) loop();
+}
+
+static bool commandLine(const std::string& name) {
+    uint8_t type;
+    if (name == "reset") type = irkframe::CMD_RESET;
+    else if (name == "list") type = irkframe::CMD_LIST;
+    else if (name == "export") type = irkframe::CMD_EXPORT;
+    else if (name == "status") type = irkframe::CMD_STATUS;
+    else return fail("unknown command '%s'", name.c_str());
+
+    uint8_t frame[irkframe::MAX_FRAME];
+    size_t n = irkframe::encode(type, NULL, 0, frame, sizeof(frame));
+    host_serial_inject(frame, n);
+    loop();
+    return true;
+}
+
+static bool expectValue(const std::string& key, const std::string& want) {
+    char got[64];
+    IrkPublishStats pub = irk_publish_stats();
+    if (key == "irk_retrieved") snprintf(got, sizeof(got), "%d", irkRetrieved ? 1 : 0);
+    else if (key == "irk") snprintf(got, sizeof(got), "%s", irkRetrieved ? currentIRK.c_str() : "none");
+    else if (key == "mac") snprintf(got, sizeof(got), "%s", connectedDeviceMAC.c_str());
+    else if (key == "pair_count") snprintf(got, sizeof(got), "%u", currentPairCount);
+    else if (key == "published") snprintf(got, sizeof(got), "%u", pub.published);
+    else if (key == "duplicates") snprintf(got, sizeof(got), "%u", pub.duplicates);
+    else if (key == "irk_frames") snprintf(got, sizeof(got), "%u", current->irkFrames);
+    else if (key == "irk_frame_mac") snprintf(got, sizeof(got), "%s", current->irkFrameMac[0] ? current->irkFrameMac : "none");
+    else if (key == "list_count") snprintf(got, sizeof(got), "%d", current->listCount);
+    else if (key == "bonds") snprintf(got, sizeof(got), "%d", esp_ble_get_bond_device_num());
+    else if (key == "known_devices") snprintf(got, sizeof(got), "%u", irk_index_count());
+    else if (key == "adv_starts") snprintf(got, sizeof(got), "%u", host_calls.advStarts);
+    else if (key == "encryption_requests") snprintf(got, sizeof(got), "%u", host_calls.encryptionRequests);
+    else if (key == "disconnects") snprintf(got, sizeof(got), "%u", host_calls.disconnects);
+    else if (key == "stage_samples") snprintf(got, sizeof(got), "%u", pairing_stats_stages().samples);
+    else return fail("unknown expectation '%s'", key.c_str());
+
+    if (strcasecmp(got, want.c_str()) != 0) {
+        return fail("expected %s=%s, got %s", key.c_str(), want.c_str(), got);
+    }
+    return true;
+}
+
+static bool runLine(const std::vector<std::string>& tokens) {
+    const std::string& what = tokens[0];
+    if (what == "gap" || what == "gatts") {
+        if (tokens.size() < 2) return fail("missing event name");
+        Args args = parseArgs(tokens, 2);
+        return what == "gap" ? gapEvent(tokens[1], args) : gattsEvent(tokens[1], args);
+    }
+    if (what == "bond") return bondLine(parseArgs(tokens, 1));
+    if (what == "wait") {
+        if (tokens.size() < 2) return fail("wait needs a duration in ms");
+        waitMs(strtol(tokens[1].c_str(), NULL, 0));
+        return true;
+    }
+    if (what == "command") {
+        if (tokens.size() < 2) return fail("missing command");
+        return commandLine(tokens[1]);
+    }
+    if (what == "expect") {
+        Args args = parseArgs(tokens, 1);
+        for (Args::const_iterator it = args.begin(); it != args.end(); ++it) {
+            if (!expectValue(it->first, it->second)) return false;
+        }
+        return true;
+    }
+    return fail("unknown directive '%s'", what.c_str());
+}
+
+static int replayFile(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+
+    Replay replay;
+    replay.path = path;
+    replay.line = 0;
+    replay.gattsIf = 3;
+    replay.irkFrames = 0;
+    replay.irkFrameMac[0] = 0;
+    replay.listCount = -1;
+    current = &replay;
+    host_set_serial_sink(onSerial);
+    setup();
+
+    char line[512];
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), f)) {
+        replay.line++;
+        line[strcspn(line, "\r\n")] = '\0';
+        std::vector<std::string> tokens = split(line);
+        if (!tokens.empty()) ok = runLine(tokens);
+    }
+    fclose(f);
+
+    printf("%s %s\n", ok ? "PASS" : "FAIL", path);
+    printf("  %-20s %6s %10s %10s\n", "event", "count", "avg us", "max us");
+    for (std::map<std::string, Timing>::const_iterator it = replay.timings.begin(); it != replay.timings.end(); ++it) {
+        const Timing& t = it->second;
+        printf("  %-20s %6u %10.2f %10.2f\n", it->first.c_str(), t.count,
+               t.totalNs / 1000.0 / t.count, t.maxNs / 1000.0);
+    }
+    fflush(stdout);
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    int first = 1;
+    if (argc > 1 && !strcmp(argv[1], "-v")) {
+        host_verbose = true;
+        first = 2;
+    }
+    if (first >= argc) {
+        fprintf(stderr, "usage: %s [-v] trace...\n", argv[0]);
+        return 2;
+    }
+
+    int failed = 0;
+    for (int i = first; i < argc; i++) {
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0) _exit(replayFile(argv[i]));
+        int status = 0;
+        while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) failed++;
+    }
+    printf("%d traces, %d failed\n", argc - first, failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,136 @@
+#!/bin/bash
+
+# Script to update ESP32 IRK Finder firmware over WiFi (POST /api/ota)
+# Usage: ./upload-ota.sh <host> <firmware.bin|firmware.bin.gz> [--compare]
+#
+# host is the device address, e.g. esp32-irk-finder.local or 192.168.1.100
+# --compare uploads the plain and the gzip form of the same image one after
+# the other and prints their timings side by side
+# Set OTA_TOKEN in the environment to the token the firmware was built with;
+# firmware built without one refuses uploads
+
+# Color codes
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+RED='\033[0;31m'
+BLUE='\033[0;34m'
+NC='\033[0m' # No Color
+
+echo -e "${BLUE}ESP32 IRK Finder OTA Uploader${NC}"
+echo "==========================================="
+echo ""
+
+HOST="$1"
+IMAGE="$2"
+COMPARE=false
+if [ "$3" = "--compare" ]; then
+    COMPARE=true
+fi
+
+if [ -z "$HOST" ] || [ ! -f "$IMAGE" ]; then
+    echo -e "${RED}Usage: $0 <host> <firmware.bin|firmware.bin.gz> [--compare]${NC}"
+    exit 1
+fi
+
+# SHA-256 of the uncompressed image, from the release sidecar when present
+image_sha256() {
+    case "$1" in
+        *.gz)
+            if [ -f "${1%.gz}.sha256" ]; then
+                cat "${1%.gz}.sha256"
+            else
+                gzip -dc "$1" | sha256sum | cut -d' ' -f1
+            fi
+            ;;
+        *)
+            sha256sum "$1" | cut -d' ' -f1
+            ;;
+    esac
+}
+
+# Uploads one image; leaves the device JSON in $RESPONSE and the curl
+# timings in $TIMING
+upload() {
+    local file="$1"
+    local sha
+    sha=$(image_sha256 "$file")
+    local token_header=()
+    if [ -n "$OTA_TOKEN" ]; then
+        token_header=(-H "X-OTA-Token: $OTA_TOKEN")
+    fi
+
+    echo -e "${YELLOW}Uploading $(basename "$file") ($(stat -c %s "$file") bytes)...${NC}"
+    local out
+    out=$(curl -sS -X POST --data-binary @"$file" \
+        -H "Content-Type: application/octet-stream" \
+        -H "X-Firmware-SHA256: $sha" \
+        "${token_header[@]}" \
+        -w '\n%{http_code} %{time_total} %{size_upload}' \
+        "http://$HOST/api/ota")
+    if [ $? -ne 0 ]; then
+        echo -e "${RED}Upload failed: no response from $HOST${NC}"
+        return 1
+    fi
+    RESPONSE=$(echo "$out" | head -n -1)
+    TIMING=$(echo "$out" | tail -n 1)
+    local code=${TIMING%% *}
+    echo "$RESPONSE"
+    if [ "$code" != "200" ]; then
+        echo -e "${RED}Upload rejected (HTTP $code)${NC}"
+        return 1
+    fi
+    echo -e "${GREEN}Verified in $(echo "$TIMING" | cut -d' ' -f2) s, device restarting${NC}"
+    return 0
+}
+
+# Waits for the device to answer again after the restart
+wait_for_device() {
+    echo -e "${YELLOW}Waiting for $HOST to come back...${NC}"
+    sleep 5
+    for i in $(seq 1 60); do
+        if curl -s -o /dev/null --max-time 2 "http://$HOST/api/status"; then
+            return 0
+        fi
+        sleep 1
+    done
+    echo -e "${RED}$HOST did not come back within a minute${NC}"
+    return 1
+}
+
+json_field() {
+    echo "$1" | grep -o "\"$2\": *[0-9a-z]*" | sed 's/.*: *//'
+}
+
+if [ "$COMPARE" = false ]; then
+    upload "$IMAGE" || exit 1
+    exit 0
+fi
+
+# Build both forms of the image in a scratch directory
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+case "$IMAGE" in
+    *.gz)
+        gzip -dc "$IMAGE" > "$WORK/firmware.bin"
+        ;;
+    *)
+        cp "$IMAGE" "$WORK/firmware.bin"
+        ;;
+esac
+gzip -9 -n -c "$WORK/firmware.bin" > "$WORK/firmware.bin.gz"
+
+RESULTS=()
+for file in "$WORK/firmware.bin" "$WORK/firmware.bin.gz"; do
+    upload "$file" || exit 1
+    RESULTS+=("$(basename "$file") $(echo "$TIMING" | cut -d' ' -f3) $(echo "$TIMING" | cut -d' ' -f2) \
+$(json_field "$RESPONSE" elapsedMs) $(json_field "$RESPONSE" minFreeHeap)")
+    wait_for_device || exit 1
+    echo ""
+done
+
+echo -e "${GREEN}════════════════════════════════════════════${NC}"
+printf "%-16s %10s %10s %10s %12s\n" "image" "sent (B)" "wall (s)" "device ms" "min heap (B)"
+for row in "${RESULTS[@]}"; do
+    printf "%-16s %10s %10s %10s %12s\n" $row
+done
+echo -e "${GREEN}════════════════════════════════════════════${NC}"